@@ -0,0 +1,876 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <glua/backends/lua.hpp>
+#include <glua/backends/spidermonkey.hpp>
+
+namespace checks {
+struct checked_counter {
+    int increment() { return ++value_; }
+
+    int value_ { 0 };
+};
+
+struct jit_counter {
+    int add(int amount) { return value_ += amount; }
+
+    int value_ { 0 };
+};
+
+// counts how often it is formatted, to tell when an error's message is built
+struct format_counted {
+    int* formats_;
+};
+}
+
+template <>
+struct std::formatter<checks::format_counted> : std::formatter<std::string_view> {
+    auto format(const checks::format_counted& counted, std::format_context& ctx) const
+    {
+        ++*counted.formats_;
+        return std::formatter<std::string_view>::format("counted", ctx);
+    }
+};
+
+template <>
+struct glua::class_registration<checks::checked_counter> {
+    static inline const std::string name { "checked_counter" };
+
+    static inline auto constructor = glua::create_generic_functor([]() { return std::make_unique<checks::checked_counter>(); });
+    static inline auto methods = std::make_tuple(GLUABIND(checks::checked_counter::increment));
+    static inline auto fields = std::make_tuple(GLUABIND(checks::checked_counter::value_));
+};
+
+template <>
+struct glua::class_registration<checks::jit_counter> {
+    static inline const std::string name { "jit_counter" };
+    static constexpr bool jit_info = true;
+
+    static inline auto constructor = glua::create_generic_functor([]() { return std::make_unique<checks::jit_counter>(); });
+    static inline auto methods = std::make_tuple(GLUABIND(checks::jit_counter::add));
+    static inline auto fields = std::make_tuple(GLUABIND(checks::jit_counter::value_));
+};
+
+// behavioral checks of backend features, run with `libglua-examples --checks`. Every check prints PASS or
+// FAIL, and the run exits non-zero once any of them failed
+namespace checks {
+inline int failures { 0 };
+
+inline int checked_multiply(int lhs, int rhs)
+{
+    return lhs * rhs;
+}
+
+inline void expect(bool condition, std::string_view what)
+{
+    std::cout << std::format("[{}] {}\n", condition ? "PASS" : "FAIL", what);
+    if (!condition) {
+        ++failures;
+    }
+}
+
+template <typename T>
+void expect_value(const glua::result<T>& actual, const T& expected, std::string_view what)
+{
+    if (!actual.has_value()) {
+        expect(false, std::format("{} (error: {})", what, actual.error()));
+    } else {
+        expect(actual.value() == expected, what);
+    }
+}
+
+inline void expect_success(const glua::result<void>& actual, std::string_view what)
+{
+    if (!actual.has_value()) {
+        expect(false, std::format("{} (error: {})", what, actual.error()));
+    } else {
+        expect(true, what);
+    }
+}
+
+// runs f with a new instance of Backend, failing the check if one couldn't be created
+template <typename Backend, typename F, typename... CreateArgs>
+void with_instance(std::string_view what, F&& f, CreateArgs&&... create_args)
+{
+    auto glue = glua::instance<Backend>::create(std::forward<CreateArgs>(create_args)...);
+    if (!glue.has_value()) {
+        expect(false, std::format("{} (could not create instance: {})", what, glue.error()));
+        return;
+    }
+
+    f(glue.value());
+}
+
+inline std::filesystem::path scratch_directory(std::string_view name)
+{
+    auto directory = std::filesystem::temp_directory_path() / std::format("glua-checks-{}", name);
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+
+inline void script_cache_checks()
+{
+    using backend = glua::spidermonkey::backend;
+
+    const auto directory = scratch_directory("script-cache");
+    const std::string code { "var cached_value = 6 * 7; cached_value" };
+
+    with_instance<backend>("script cache: first run stores", [&](auto& glue) {
+        expect_success(glue.get_backend().enable_script_cache(directory), "script cache: enable");
+        expect_value(glue.template execute_script<int>(code), 42, "script cache: first run result");
+
+        auto stats = glue.get_backend().get_script_cache_stats();
+        expect(stats && stats->misses_ == 1 && stats->stores_ == 1, "script cache: first run misses and stores");
+    });
+
+    with_instance<backend>("script cache: round trip", [&](auto& glue) {
+        expect_success(glue.get_backend().enable_script_cache(directory), "script cache: enable again");
+        expect_value(glue.template execute_script<int>(code), 42, "script cache: decoded script result");
+
+        auto stats = glue.get_backend().get_script_cache_stats();
+        expect(stats && stats->hits_ == 1 && stats->misses_ == 0, "script cache: second instance decodes the stored entry");
+    });
+
+    // writers sharing the directory are told apart by process and by thread, and leave no temp files behind
+    std::string other_writer;
+    std::thread { [&]() { other_writer = glua::spidermonkey::writer_id(); } }.join();
+#ifndef _WIN32
+    expect(glua::spidermonkey::writer_id().starts_with(std::format("{}-", getpid())), "script cache: temp names carry the process id");
+#endif
+    expect(other_writer != glua::spidermonkey::writer_id(), "script cache: temp names differ per thread");
+    expect(std::ranges::none_of(std::filesystem::directory_iterator { directory }, [](const auto& file) { return file.path().extension() == ".tmp"; }),
+        "script cache: stores leave no temp files");
+    expect(glua::spidermonkey::engine_build_id() == glua::spidermonkey::engine_build_id() && glua::spidermonkey::engine_build_id().starts_with("glua-"),
+        "script cache: the build id is stable within a process");
+
+    // an entry written by another build must be a miss, and is replaced
+    const auto entry = directory / std::format("{:016x}.xdr", glua::spidermonkey::stable_hash(code));
+    {
+        std::ifstream file { entry, std::ios::binary };
+        std::string contents { std::istreambuf_iterator<char> { file }, {} };
+        auto build_id = glua::spidermonkey::engine_build_id();
+        if (auto pos = contents.find(build_id); pos != std::string::npos) {
+            contents.replace(pos, build_id.size(), std::string(build_id.size(), '0'));
+        }
+
+        std::ofstream out { entry, std::ios::binary | std::ios::trunc };
+        out << contents;
+    }
+
+    with_instance<backend>("script cache: header mismatch", [&](auto& glue) {
+        expect_success(glue.get_backend().enable_script_cache(directory), "script cache: enable with foreign entry");
+        expect_value(glue.template execute_script<int>(code), 42, "script cache: foreign entry still runs the script");
+
+        auto stats = glue.get_backend().get_script_cache_stats();
+        expect(stats && stats->hits_ == 0 && stats->misses_ == 1 && stats->stores_ == 1, "script cache: foreign build id is a miss and is rewritten");
+
+        std::ifstream file { entry, std::ios::binary };
+        std::string contents { std::istreambuf_iterator<char> { file }, {} };
+        expect(contents.starts_with(glua::spidermonkey::script_cache::make_header(glua::spidermonkey::stable_hash(code), code.size())),
+            "script cache: rewritten entry carries this build's id");
+    });
+
+    with_instance<backend>("script cache: eviction", [&](auto& glue) {
+        const auto small_directory = scratch_directory("script-cache-evict");
+        expect_success(glue.get_backend().enable_script_cache(small_directory, 1), "script cache: enable with a tiny bound");
+        expect_value(glue.template execute_script<int>("1 + 1"), 2, "script cache: first bounded script");
+        expect_value(glue.template execute_script<int>("2 + 2"), 4, "script cache: second bounded script");
+
+        std::size_t entries { 0 };
+        for (const auto& file : std::filesystem::directory_iterator { small_directory }) {
+            entries += file.path().extension() == ".xdr" ? 1 : 0;
+        }
+
+        auto stats = glue.get_backend().get_script_cache_stats();
+        expect(entries == 0 && stats && stats->evictions_ == 2, "script cache: entries past the bound are evicted");
+    });
+}
+
+inline void parallel_compile_checks()
+{
+    with_instance<glua::spidermonkey::backend>("parallel compilation", [&](auto& glue) {
+        // large enough that spidermonkey hands them to helper threads rather than compiling inline
+        std::vector<std::string> sources;
+        for (int i = 0; i < 16; ++i) {
+            std::string code;
+            for (int j = 0; j < 2000; ++j) {
+                code += std::format("function unused_{}_{}() {{ return {}; }}\n", i, j, j);
+            }
+            code += std::format("{} * 2", i);
+            sources.push_back(std::move(code));
+        }
+
+        auto compiled = glue.get_backend().compile_scripts(sources);
+        expect(compiled.has_value() && compiled->size() == sources.size(), "parallel compilation: every source compiles");
+        if (!compiled.has_value()) {
+            return;
+        }
+
+        bool all_correct { true };
+        for (int i = 0; i < 16; ++i) {
+            auto value = glue.get_backend().template execute_script<int>((*compiled)[i]);
+            all_correct = all_correct && value.has_value() && value.value() == i * 2;
+        }
+        expect(all_correct, "parallel compilation: results keep the order of their sources");
+    });
+}
+
+template <typename Backend>
+void function_handle_checks(std::string_view backend_name, std::string_view script)
+{
+    with_instance<Backend>(std::format("{} function handles", backend_name), [&](auto& glue) {
+        expect_success(glue.template execute_script<void>(std::string { script }), std::format("{} function handles: define function", backend_name));
+
+        auto handle = glue.template get_function<int(int, int)>("checked_add");
+        expect(handle.has_value(), std::format("{} function handles: resolve by name", backend_name));
+        if (handle.has_value()) {
+            expect_value(handle->call(2, 3), 5, std::format("{} function handles: first call", backend_name));
+            expect_value(handle->call(40, 2), 42, std::format("{} function handles: repeated call", backend_name));
+        }
+
+        expect(!glue.template get_function<int(int, int)>("not_defined").has_value(), std::format("{} function handles: missing function is an error", backend_name));
+    });
+}
+
+template <typename Backend>
+void batch_call_checks(std::string_view backend_name, std::string_view script)
+{
+    with_instance<Backend>(std::format("{} batch calls", backend_name), [&](auto& glue) {
+        expect_success(glue.template execute_script<void>(std::string { script }), std::format("{} batch calls: define function", backend_name));
+
+        std::vector<std::tuple<int, int>> inputs { { 1, 2 }, { 20, 22 }, { -5, 5 } };
+        std::vector<int> sums(inputs.size());
+        expect_success(glue.template call_function_batch<int>("checked_add", inputs, sums), std::format("{} batch calls: call over a vector of inputs", backend_name));
+        expect(sums == std::vector<int> { 3, 42, 0 }, std::format("{} batch calls: each result lands at its input's index", backend_name));
+
+        std::vector<int> too_small(1);
+        auto short_output = glue.template call_function_batch<int>("checked_add", inputs, too_small);
+        expect(!short_output.has_value() && short_output.error().code() == glua::error_code::invalid_arguments,
+            std::format("{} batch calls: an output smaller than the inputs is an error", backend_name));
+    });
+}
+
+// a C++ object reached from JS through its wrapper, with the wrapper's state in its reserved slots
+inline void wrapper_checks()
+{
+    with_instance<glua::spidermonkey::backend>("wrappers", [&](auto& glue) {
+        checked_counter counter;
+        expect_success(glue.template register_class<checked_counter>(), "wrappers: register class");
+        expect_success(glue.register_functor("get_counter", [&]() { return &counter; }), "wrappers: register functor");
+
+        expect_value(glue.template execute_script<int>("var c = get_counter(); c.increment(); c.increment(); c.value_"), 2, "wrappers: method and field through the wrapper");
+        expect(counter.value_ == 2, "wrappers: calls reach the C++ object");
+        expect_value(glue.template execute_script<int>("var owned = new checked_counter(); owned.increment()"), 1, "wrappers: script constructed object");
+    });
+}
+
+// the same C++ object reaches JS as the same JS object, for as long as the wrapper is alive
+inline void wrapper_identity_checks()
+{
+    with_instance<glua::spidermonkey::backend>("wrapper identity", [&](auto& glue) {
+        checked_counter first;
+        checked_counter second;
+        expect_success(glue.template register_class<checked_counter>(), "wrapper identity: register class");
+        expect_success(glue.register_functor("get_first", [&]() { return &first; }), "wrapper identity: register first");
+        expect_success(glue.register_functor("get_second", [&]() { return &second; }), "wrapper identity: register second");
+
+        expect_value(glue.template execute_script<bool>("var kept = get_first(); kept.tag = 'x'; get_first() === kept && get_first().tag === 'x'"), true,
+            "wrapper identity: same object, same wrapper");
+        expect_value(glue.template execute_script<bool>("get_first() !== get_second()"), true, "wrapper identity: different objects, different wrappers");
+
+        glue.get_backend().collect_garbage();
+        expect_value(glue.template execute_script<bool>("get_first() === kept"), true, "wrapper identity: a reachable wrapper survives a collection");
+    });
+}
+
+// a class with JSJitInfo attached must behave the same once its methods and getters are called from JIT code
+inline void jit_info_checks()
+{
+    with_instance<glua::spidermonkey::backend>("jit info", [&](auto& glue) {
+        jit_counter counter;
+        expect_success(glue.template register_class<jit_counter>(), "jit info: register class");
+        expect_success(glue.register_functor("get_jit_counter", [&]() { return &counter; }), "jit info: register functor");
+
+        // enough iterations for the loop to reach the optimizing tiers
+        expect_value(glue.template execute_script<int>(
+                         "var j = get_jit_counter(); var seen = 0; for (var i = 0; i < 100000; ++i) { j.add(1); seen += j.value_ === i + 1 ? 1 : 0; } seen"),
+            100000, "jit info: getter matches the method in a hot loop");
+        expect(counter.value_ == 100000, "jit info: hot loop calls reach the C++ object");
+
+        expect(!glue.template execute_script<int>("get_jit_counter().add.call({}, 1)").has_value(), "jit info: method on a foreign this is an error");
+    });
+}
+
+inline void typed_array_checks()
+{
+    with_instance<glua::spidermonkey::backend>("typed arrays", [&](auto& glue) {
+        using glua::spidermonkey::typed_array;
+
+        expect_success(glue.register_functor("plain_ints", []() { return std::vector<int> { 1, 2, 3 }; }), "typed arrays: register plain vector");
+        expect_success(glue.register_functor("typed_doubles", []() { return typed_array<double> { { 0.5, 1.5 } }; }), "typed arrays: register typed array");
+        expect_success(glue.register_functor("sum_typed", [](typed_array<int32_t> v) { return std::accumulate(v.values_.begin(), v.values_.end(), 0); }),
+            "typed arrays: register typed array parameter");
+        expect_success(glue.register_functor("sum_span_after_gc", [&](std::span<const int32_t> v, std::string label) {
+            // the span must survive a collection during the call, including a move of a small array out of the nursery
+            glue.get_backend().collect_garbage();
+            return static_cast<int>(label.size()) + std::accumulate(v.begin(), v.end(), 0);
+        }),
+            "typed arrays: register span parameter");
+
+        expect_value(glue.template execute_script<bool>("Array.isArray(plain_ints())"), true, "typed arrays: a vector stays a plain Array");
+        expect_value(glue.template call_function<std::vector<int>>("plain_ints"), std::vector<int> { 1, 2, 3 }, "typed arrays: a vector round trips");
+        expect_value(glue.template execute_script<bool>("var d = typed_doubles(); d instanceof Float64Array && d[1] === 1.5"), true,
+            "typed arrays: the wrapper becomes a typed array");
+        expect_value(glue.template execute_script<int>("sum_typed(new Int32Array([1, 2, 3])) + sum_typed([4, 5])"), 15,
+            "typed arrays: the wrapper accepts typed and generic arrays");
+        expect_value(glue.template execute_script<int>("sum_span_after_gc(new Int32Array([10, 20, 30]), 'abcd')"), 64,
+            "typed arrays: a span of a small array survives a GC during the call");
+        expect(!glue.template execute_script<int>("sum_span_after_gc(new Float64Array(3), '')").has_value(), "typed arrays: a span of the wrong type is an error");
+    });
+}
+
+inline void string_checks()
+{
+    with_instance<glua::spidermonkey::backend>("strings", [&](auto& glue) {
+        expect_success(glue.register_functor("join_after_gc", [&](std::string_view first, std::string_view second) {
+            // a view must not be invalidated by a collection during the call
+            glue.get_backend().collect_garbage();
+            return std::string { first } + "|" + std::string { second };
+        }),
+            "strings: register view parameters");
+        expect_success(glue.register_functor("large_text", []() { return std::u16string(4096, u'x'); }), "strings: register external string");
+
+        expect_value(glue.template execute_script<std::string>("join_after_gc('ab'.repeat(2), 'length')"), std::string { "abab|length" },
+            "strings: views of a nursery string and an atom survive a GC");
+        expect_value(glue.template execute_script<std::string>("join_after_gc('h\u00e9', '\u4e16')"), std::string { "h\xc3\xa9|\xe4\xb8\x96" },
+            "strings: non-ascii views are UTF-8");
+        expect_success(glue.register_functor("same_chars", [](std::string_view first, std::string_view second) { return first.data() == second.data(); }),
+            "strings: register a view comparison");
+        expect_success(glue.template execute_script<void>("var viewed = 'q'.repeat(256) + 'x';"), "strings: create a long string");
+        glue.get_backend().collect_garbage();
+        expect_value(glue.template execute_script<bool>("same_chars(viewed, viewed)"), true,
+            "strings: a tenured ascii argument is viewed in the engine's chars, not copied per argument");
+
+        expect_value(glue.template execute_script<int>("var t = large_text(); t.length"), 4096, "strings: moved u16string reaches the script");
+        expect_value(glue.template get_global<std::u16string>("t"), std::u16string(4096, u'x'), "strings: u16string round trip");
+
+        glue.get_backend().collect_garbage();
+        expect_value(glue.template execute_script<bool>("t === 'x'.repeat(4096)"), true, "strings: external string survives a collection");
+    });
+}
+
+inline void map_object_checks()
+{
+    with_instance<glua::spidermonkey::backend>("map objects", [&](auto& glue) {
+        using record = std::unordered_map<std::string, int>;
+
+        // the same keys inserted in a different order, and so likely in a different bucket order
+        record first;
+        record second;
+        for (int i = 0; i < 32; ++i) {
+            first.emplace(std::format("key_{}", i), i);
+            second.emplace(std::format("key_{}", 31 - i), 31 - i);
+        }
+        second.emplace("caf\xc3\xa9", 7);
+        first.emplace("caf\xc3\xa9", 7);
+
+        expect_success(glue.set_global("first", first), "map objects: set first");
+        expect_success(glue.set_global("second", second), "map objects: set second");
+
+        expect_value(glue.template execute_script<bool>("Object.keys(first).join() === Object.keys(second).join()"), true,
+            "map objects: same keys give the same property order");
+        expect_value(glue.template execute_script<bool>("var k = Object.keys(first); k.every((key, i) => i === 0 || k[i - 1] < key)"), true,
+            "map objects: properties are in sorted key order");
+        expect_value(glue.template execute_script<int>("first.key_31 + second['caf\u00e9']"), 38, "map objects: ascii and non-ascii keys");
+        expect_value(glue.template get_global<record>("second"), second, "map objects: round trip");
+    });
+}
+
+inline void map_read_checks()
+{
+    with_instance<glua::spidermonkey::backend>("map reads", [&](auto& glue) {
+        using record = std::unordered_map<std::string, int>;
+
+        expect_success(glue.template execute_script<void>("var getter_calls = 0;"
+                                                          "var inherited = { from_prototype: 1 };"
+                                                          "var config = Object.create(inherited);"
+                                                          "config.a = 1; config[2] = 2;"
+                                                          "Object.defineProperty(config, 'computed', { enumerable: true, get() { ++getter_calls; return 3; } });"),
+            "map reads: define config");
+
+        record out;
+        expect_success(glue.get_backend().get_global_into("config", out), "map reads: read into a map");
+        expect(out == record { { "a", 1 }, { "2", 2 } }, "map reads: only own data properties, including index keys");
+        expect_value(glue.template get_global<int>("getter_calls"), 0, "map reads: getters are not invoked");
+
+        expect_success(glue.template execute_script<void>("config = { b: 5 };"), "map reads: replace config");
+        expect_success(glue.get_backend().get_global_into("config", out), "map reads: read into the same map again");
+        expect(out == record { { "b", 5 } }, "map reads: the previous contents are replaced");
+
+        expect(!glue.get_backend().get_global_into("getter_calls", out).has_value(), "map reads: a non-object is an error");
+    });
+}
+
+inline void gc_callback_checks()
+{
+    with_instance<glua::spidermonkey::backend>("gc callbacks", [&](auto& glue) {
+        using glua::spidermonkey::gc_progress;
+
+        int cycles_begun { 0 };
+        int cycles_ended { 0 };
+        glue.get_backend().set_gc_callback([&](gc_progress progress) {
+            cycles_begun += progress == gc_progress::cycle_begin ? 1 : 0;
+            cycles_ended += progress == gc_progress::cycle_end ? 1 : 0;
+        });
+
+        // a threshold of zero is always exceeded, and the callback uses the engine, which is only allowed
+        // once the collection is over
+        int pressure_calls { 0 };
+        glue.get_backend().set_memory_pressure_callback(0.0, [&](glua::spidermonkey::heap_usage usage) {
+            ++pressure_calls;
+            static_cast<void>(glue.set_global("pressure_bytes", static_cast<double>(usage.bytes_)));
+        });
+
+        glue.get_backend().collect_garbage();
+        expect(cycles_begun == 1 && cycles_ended == 1, "gc callbacks: a full collection is one cycle");
+        expect(pressure_calls == 1, "gc callbacks: memory pressure is reported once the collection returns");
+        expect_value(glue.template execute_script<bool>("pressure_bytes > 0"), true, "gc callbacks: the pressure callback could use the engine");
+
+        glue.get_backend().set_gc_callback({});
+        glue.get_backend().set_memory_pressure_callback(0.0, {});
+        glue.get_backend().collect_garbage();
+        expect(cycles_ended == 1 && pressure_calls == 1, "gc callbacks: empty callbacks remove them");
+    });
+}
+
+inline void heap_limit_checks()
+{
+    with_instance<glua::spidermonkey::backend>(
+        "heap limits", [&](auto& glue) {
+            auto exhausted = glue.template execute_script<void>("var hoard = []; for (;;) hoard.push(new Array(1024).fill(0));");
+            expect(!exhausted.has_value() && exhausted.error().code() == glua::error_code::out_of_memory,
+                "heap limits: allocating past the limit is an out of memory error");
+
+            auto usage = glue.get_backend().get_heap_usage();
+            expect(usage.limit_ == 32 * 1024 * 1024, "heap limits: the limit is reported");
+
+            expect_success(glue.template execute_script<void>("hoard = null;"), "heap limits: the instance runs scripts after running out");
+            glue.get_backend().collect_garbage();
+            expect_value(glue.template execute_script<int>("new Array(1000).fill(1).length"), 1000, "heap limits: memory is available again after a collection");
+        },
+        glua::spidermonkey::backend_options { .max_heap_bytes = 32 * 1024 * 1024 });
+}
+
+template <typename Backend>
+void deadline_checks(std::string_view backend_name, std::string_view runaway, std::string_view catching, std::string_view warm_loop, std::string_view returns_one)
+{
+    with_instance<Backend>(std::format("{} deadlines", backend_name), [&](auto& glue) {
+        auto soon = []() { return glua::deadline::clock::now() + std::chrono::milliseconds { 100 }; };
+        auto is_deadline = [](const auto& outcome) { return !outcome.has_value() && outcome.error().code() == glua::error_code::deadline_exceeded; };
+
+        expect(is_deadline(glue.template execute_script<void>(soon(), std::string { runaway })), std::format("{} deadlines: a runaway loop is interrupted", backend_name));
+        expect(is_deadline(glue.template execute_script<void>(soon(), std::string { catching })),
+            std::format("{} deadlines: catching the interruption doesn't escape it", backend_name));
+
+        // warmed up first, so a JIT has compiled the loop by the time it runs past its deadline
+        expect_success(glue.template execute_script<void>(std::string { warm_loop }), std::format("{} deadlines: warm up a loop", backend_name));
+        expect(is_deadline(glue.template call_function<int>(soon(), "spin")), std::format("{} deadlines: a compiled loop is interrupted", backend_name));
+
+        expect_value(glue.template execute_script<int>(soon(), std::string { returns_one }), 1, std::format("{} deadlines: the instance remains usable", backend_name));
+    });
+}
+
+// a deadline call puts the JIT back the way the host left it
+inline void lua_jit_mode_checks()
+{
+    with_instance<glua::lua::backend>("lua jit mode", [&](auto& glue) {
+        auto soon = []() { return glua::deadline::clock::now() + std::chrono::milliseconds { 100 }; };
+        expect(glue.get_backend().jit_enabled(), "lua jit mode: the jit starts on");
+
+        expect_value(glue.template execute_script<int>(soon(), "return 1"), 1, "lua jit mode: a deadline call with the jit on");
+        expect(glue.get_backend().jit_enabled(), "lua jit mode: the jit is on again after the call");
+
+        glue.get_backend().set_jit_enabled(false);
+        expect_value(glue.template execute_script<int>(soon(), "return 1"), 1, "lua jit mode: a deadline call with the jit off");
+        expect(!glue.get_backend().jit_enabled(), "lua jit mode: a jit the host turned off stays off");
+        glue.get_backend().set_jit_enabled(true);
+    });
+}
+
+inline void promise_checks()
+{
+    with_instance<glua::spidermonkey::backend>("promises", [&](auto& glue) {
+        std::promise<int> answer;
+        expect_success(glue.register_functor("later", [&]() { return answer.get_future(); }), "promises: register future functor");
+        expect_success(glue.template execute_script<void>("var settled = 'pending';"
+                                                          "later().then(v => { settled = v; });"
+                                                          "(async () => { await null; awaited = true; })();"
+                                                          "var awaited = false;"),
+            "promises: start asynchronous work");
+
+        expect(glue.get_backend().run_pending_jobs() == 1, "promises: an unready future stays outstanding");
+        expect_value(glue.template execute_script<bool>("awaited && settled === 'pending'"), true, "promises: jobs run, the promise waits for its future");
+
+        answer.set_value(42);
+        expect(glue.get_backend().run_pending_jobs() == 0, "promises: a ready future is settled");
+        expect_value(glue.template get_global<int>("settled"), 42, "promises: the script sees the future's value");
+    });
+}
+
+// one instance per thread, each with its own context and its own class registrations
+inline void thread_instance_checks()
+{
+    constexpr int thread_count { 4 };
+    std::vector<int> results(thread_count, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&results, i]() {
+            auto glue = glua::instance<glua::spidermonkey::backend>::create();
+            if (!glue.has_value() || !glue->template register_class<checked_counter>().has_value()) {
+                return;
+            }
+
+            auto value = glue->template execute_script<int>(std::format("var c = new checked_counter(); for (var i = 0; i < {}; ++i) c.increment(); c.value_", i + 1));
+            results[i] = value.value_or(0);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    expect(results == std::vector<int> { 1, 2, 3, 4 }, "threads: every thread's instance registers classes and runs scripts");
+
+    with_instance<glua::lua::backend>("lua class registration", [&](auto& glue) {
+        expect_success(glue.template register_class<checked_counter>(), "lua class registration: returns a result");
+        expect_value(glue.template execute_script<int>("local c = checked_counter() c:increment() return c.value_"), 1, "lua class registration: usable class");
+    });
+}
+
+inline void shared_sandbox_checks()
+{
+    with_instance<glua::spidermonkey::backend>("shared sandboxes", [&](auto& glue) {
+        using glua::spidermonkey::backend;
+
+        auto sandbox = glue.get_backend().create_sandbox(backend::sandbox_compartment::shared);
+        expect(sandbox.has_value(), "shared sandboxes: create");
+        if (!sandbox.has_value()) {
+            return;
+        }
+
+        checked_counter counter;
+        auto prepare = [&](std::string_view where) {
+            expect_success(glue.template register_class<checked_counter>(), std::format("shared sandboxes: register class in {}", where));
+            expect_success(glue.register_functor("get_counter", [&]() { return &counter; }), std::format("shared sandboxes: register functor in {}", where));
+        };
+
+        prepare("the default scope");
+        expect_success(glue.set_global("only_default", 1), "shared sandboxes: set a default scope global");
+
+        glue.get_backend().set_active_sandbox(&sandbox.value());
+        prepare("the sandbox");
+        expect(!glue.template get_global<int>("only_default").has_value(), "shared sandboxes: globals stay separate");
+        expect_value(glue.template execute_script<int>("get_counter().increment()"), 1, "shared sandboxes: bound objects work in the sandbox");
+
+        glue.get_backend().set_active_sandbox(nullptr);
+        expect_value(glue.template execute_script<int>("get_counter().increment()"), 2, "shared sandboxes: both scopes reach the same C++ object");
+    });
+}
+
+// every context after the first decodes the builtins written in JS, so those must work in all of them,
+// including contexts created at the same time
+inline void self_hosted_checks()
+{
+    constexpr int thread_count { 8 };
+    std::vector<std::string> results(thread_count);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&results, i]() {
+            auto glue = glua::instance<glua::spidermonkey::backend>::create();
+            if (!glue.has_value()) {
+                return;
+            }
+
+            // map, sort with a comparator and padStart are all self-hosted
+            auto value = glue->template execute_script<std::string>(
+                std::format("[3, 1, 2].map(x => x * {}).sort((a, b) => b - a).join('-').padStart(12, '.')", i + 1));
+            results[i] = value.value_or("");
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    bool all_correct { true };
+    for (int i = 0; i < thread_count; ++i) {
+        auto expected = std::format("{}-{}-{}", 3 * (i + 1), 2 * (i + 1), i + 1);
+        all_correct = all_correct && results[i] == std::string(12 - std::min<std::size_t>(12, expected.size()), '.') + expected;
+    }
+    expect(all_correct, "self-hosted code: builtins work in contexts created concurrently");
+
+    with_instance<glua::spidermonkey::backend>("self-hosted code", [&](auto& glue) {
+        expect_value(glue.template execute_script<std::string>("Array.from('abc', c => c.toUpperCase()).join('')"), std::string { "ABC" },
+            "self-hosted code: builtins work in a later context");
+    });
+}
+
+inline void jit_config_checks()
+{
+    with_instance<glua::spidermonkey::backend>(
+        "jit tiers", [&](auto& glue) {
+            auto config = glue.get_backend().get_jit_config();
+            expect(config.baseline_jit_enabled_ && config.baseline_jit_warmup_ == 10 && config.ion_enabled_ && config.ion_warmup_ == 100,
+                "jit tiers: the configured tiers are in effect");
+
+            expect_value(glue.template execute_script<int>("function hot(x) { return x + 1; } var total = 0; for (var i = 0; i < 10000; ++i) total = hot(total); total"), 10000,
+                "jit tiers: a hot function runs");
+
+            auto memory = glue.get_backend().get_jit_memory_snapshot();
+            expect(memory.has_value() && memory->jit_scripts_bytes_ > 0, "jit tiers: the snapshot sees the warmed up script");
+
+            // the snapshot sizes blocks through the allocator the engine allocates from
+            void* block = js_malloc(100);
+            expect(block != nullptr && glua::spidermonkey::malloc_size_of(block) >= 100, "jit tiers: engine blocks are sized by the engine's allocator");
+            js_free(block);
+        },
+        glua::spidermonkey::backend_options { .baseline_jit_enabled = true, .baseline_jit_warmup = 10, .ion_enabled = true, .ion_warmup = 100 });
+}
+
+inline void sandbox_memory_checks()
+{
+    with_instance<glua::spidermonkey::backend>("sandbox memory", [&](auto& glue) {
+        auto tenant = glue.get_backend().create_sandbox();
+        expect(tenant.has_value(), "sandbox memory: create a sandbox");
+        if (!tenant.has_value()) {
+            return;
+        }
+
+        const std::array<const glua::spidermonkey::backend::sandbox*, 2> sandboxes { nullptr, &tenant.value() };
+        auto before = glue.get_backend().get_sandbox_memory(sandboxes);
+
+        glue.get_backend().set_active_sandbox(&tenant.value());
+        expect_success(glue.template execute_script<void>("var hoard = []; for (var i = 0; i < 20000; ++i) hoard.push({ i: i, s: 'x' + i });"),
+            "sandbox memory: grow the sandbox");
+        glue.get_backend().set_active_sandbox(nullptr);
+
+        // the counters cover the tenured heap, so the new objects are moved out of the nursery first
+        glue.get_backend().collect_garbage();
+        auto after = glue.get_backend().get_sandbox_memory(sandboxes);
+        expect(after.size() == 2 && after[1] > before[1], "sandbox memory: the growing sandbox's counter grows");
+
+        auto report = glue.get_backend().get_sandbox_memory_report(sandboxes);
+        expect(report.has_value() && report->size() == 2 && (*report)[1].gc_heap_bytes_ > (*report)[0].gc_heap_bytes_,
+            "sandbox memory: the full report breaks down the same sandboxes");
+    });
+}
+
+inline void profiler_checks()
+{
+    with_instance<glua::spidermonkey::backend>("profiler", [&](auto& glue) {
+        // the same functor registered again and again, as a sandbox setup would, keeps one name
+        auto busy = glua::create_generic_functor([]() {
+            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds { 200 };
+            while (std::chrono::steady_clock::now() < until) { }
+            return 1;
+        });
+        for (int i = 0; i < 100; ++i) {
+            static_cast<void>(glue.register_functor("checked_busy", *busy));
+        }
+
+        glue.get_backend().start_profiling(std::chrono::microseconds { 100 });
+        expect_value(glue.template execute_script<int>("function checked_outer() { var total = 0; for (var i = 0; i < 2000; ++i) total += checked_busy(); return total; }"
+                                                       "function checked_spin() { var x = 0; for (var i = 0; i < 20000000; ++i) x = (x + i) | 0; return x; }"
+                                                       "checked_spin(); checked_outer()"),
+            2000, "profiler: the profiled workload runs");
+        auto folded = glue.get_backend().stop_profiling();
+
+        expect(folded.find("checked_outer") != std::string::npos && folded.find("checked_busy") != std::string::npos,
+            "profiler: samples inside a bound C++ call carry its label under the calling script");
+        expect(folded.find("checked_spin") != std::string::npos, "profiler: samples of a JIT compiled loop are attributed to its function");
+        expect(glue.get_backend().stop_profiling().empty(), "profiler: stopping again returns nothing");
+
+        // a bound call sleeping through 50 intervals is sampled once, when it returns, but weighs all 50
+        auto nap = glua::create_generic_functor([]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 50 });
+            return 1;
+        });
+        static_cast<void>(glue.register_functor("checked_nap", *nap));
+
+        glue.get_backend().start_profiling(std::chrono::milliseconds { 1 });
+        expect_value(glue.template execute_script<int>("checked_nap()"), 1, "profiler: the sleeping call runs");
+        std::istringstream napped { glue.get_backend().stop_profiling() };
+
+        std::size_t nap_samples { 0 };
+        for (std::string line; std::getline(napped, line);) {
+            if (line.find("checked_nap") != std::string::npos) {
+                nap_samples += std::stoul(line.substr(line.rfind(' ') + 1));
+            }
+        }
+        expect(nap_samples >= 25 && nap_samples <= 100, std::format("profiler: a long C++ call weighs the intervals it ran for ({} of about 50)", nap_samples));
+    });
+}
+
+inline void sandbox_pool_checks()
+{
+    with_instance<glua::spidermonkey::backend>("sandbox pools", [&](auto& glue) {
+        using pool_type = glua::spidermonkey::backend::sandbox_pool;
+
+        int setups { 0 };
+        auto pool = pool_type::create(glue.get_backend(), [&]() -> glua::result<void> {
+            ++setups;
+            return glue.template execute_script<void>("counter = 0; function bump() { return ++counter; }");
+        });
+        expect(pool.has_value(), "sandbox pools: create");
+        if (!pool.has_value()) {
+            return;
+        }
+
+        auto in_lease = [&](auto&& f) {
+            auto lease = pool.value()->acquire();
+            if (!lease.has_value()) {
+                expect(false, std::format("sandbox pools: acquire (error: {})", lease.error()));
+                return;
+            }
+            glue.get_backend().set_active_sandbox(lease->get());
+            f();
+            glue.get_backend().set_active_sandbox(nullptr);
+        };
+
+        in_lease([&]() {
+            expect_value(glue.template execute_script<int>("bump(); bump()"), 2, "sandbox pools: first lease changes state");
+            expect_success(glue.template execute_script<void>("leaked = 'from the first request';"), "sandbox pools: first lease adds a global");
+        });
+        expect(pool.value()->idle() == 1, "sandbox pools: a released sandbox is kept");
+
+        in_lease([&]() {
+            expect_value(glue.template execute_script<int>("bump()"), 1, "sandbox pools: the next lease starts from the setup state");
+            expect_value(glue.template execute_script<bool>("typeof leaked === 'undefined'"), true, "sandbox pools: globals added by a lease are removed");
+            expect_success(glue.template execute_script<void>("var declared = 1;"), "sandbox pools: a lease declares a var");
+        });
+        expect(pool.value()->idle() == 0 && setups == 1, "sandbox pools: a sandbox that can't be reset is discarded, not reused");
+
+        in_lease([&]() { expect_value(glue.template execute_script<int>("bump()"), 1, "sandbox pools: a replacement sandbox is prepared"); });
+        expect(setups == 2, "sandbox pools: setup runs once per prepared sandbox");
+
+        // the same request script with a top level let, run through two leases of the pool
+        const std::string request { "let checked_request = bump(); checked_request" };
+        in_lease([&]() { expect_value(glue.template execute_script<int>(request), 1, "sandbox pools: a script declaring a top level let runs"); });
+        expect(pool.value()->idle() == 0 && setups == 2, "sandbox pools: a sandbox given a new lexical binding is discarded");
+        in_lease([&]() { expect_value(glue.template execute_script<int>(request), 1, "sandbox pools: the same script runs again without a redeclaration error"); });
+        expect(setups == 3, "sandbox pools: the second run got a freshly prepared sandbox");
+    });
+}
+
+inline void lua_string_view_checks()
+{
+    with_instance<glua::lua::backend>("lua string views", [&](auto& glue) {
+        expect_success(glue.template register_function<[](std::string_view text, std::string_view suffix) { return std::string { text } + std::string { suffix }; }>("checked_join"),
+            "lua string views: register a function taking views");
+        expect_value(glue.template execute_script<std::string>("local a = 'left' .. tostring(1) return checked_join(a, 'right')"), std::string { "left1right" },
+            "lua string views: view arguments read the strings on the stack");
+        expect_success(glue.template register_function<[](std::string_view first, std::string_view second) { return first.data() == second.data(); }>("checked_same_chars"),
+            "lua string views: register a view comparison");
+        expect_value(glue.template execute_script<bool>("local s = string.rep('q', 256) return checked_same_chars(s, s)"), true,
+            "lua string views: views point at lua's string rather than a copy");
+        expect_value(glue.template execute_script<std::string>("checked_text = 'kept'; return checked_text"), std::string { "kept" },
+            "lua string views: results are read as owning strings");
+    });
+}
+
+inline void error_checks()
+{
+    int formats { 0 };
+    glua::error deferred = glua::error::format(glua::error_code::not_found, "{} {} {}", std::string { "missing" }, 42, format_counted { &formats });
+    expect(deferred.code() == glua::error_code::not_found && formats == 0, "errors: a formatted error is not formatted when created");
+
+    glua::error copy { deferred };
+    expect(copy.message() == "missing 42 counted" && formats == 1, "errors: reading the message formats it");
+    expect(deferred.message() == copy.message() && deferred.message().data() == copy.message().data() && formats == 1,
+        "errors: copies share the formatted message, which is built once");
+
+    glua::error literal { glua::error_code::not_found, "checked literal" };
+    expect(literal.message() == "checked literal", "errors: a literal is kept as its text");
+
+    // a buffer filled at runtime is copied, so reusing it doesn't change the error
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "buffer %d", 1);
+    glua::error from_buffer { glua::error_code::unknown, buffer };
+    std::snprintf(buffer, sizeof(buffer), "overwritten");
+    expect(from_buffer.message() == "buffer 1" && from_buffer.message().data() != buffer, "errors: a char buffer is copied rather than borrowed");
+
+    with_instance<glua::lua::backend>("errors", [&](auto& glue) {
+        auto missing = glue.template call_function<int>("checked_missing");
+        expect(!missing.has_value() && missing.error().code() == glua::error_code::not_found && missing.error().message().find("checked_missing") != std::string_view::npos,
+            "errors: backend errors carry their formatted detail");
+    });
+}
+
+template <typename Backend>
+void static_function_checks(std::string_view backend_name, std::string_view calls, std::string_view wrong_arity)
+{
+    with_instance<Backend>(std::format("{} static functions", backend_name), [&](auto& glue) {
+        expect_success(glue.template register_function<&checked_multiply>("checked_multiply"), std::format("{} static functions: register a function pointer", backend_name));
+        expect_success(glue.template register_function<[](std::string text) { return text + "!"; }>("checked_shout"),
+            std::format("{} static functions: register a captureless lambda", backend_name));
+
+        expect_value(glue.template execute_script<std::string>(std::string { calls }), std::string { "42!" }, std::format("{} static functions: calls convert arguments and results", backend_name));
+        expect(!glue.template execute_script<int>(std::string { wrong_arity }).has_value(), std::format("{} static functions: a wrong argument count is an error", backend_name));
+    });
+}
+
+inline int run()
+{
+    script_cache_checks();
+    parallel_compile_checks();
+    function_handle_checks<glua::spidermonkey::backend>("spidermonkey", "function checked_add(a, b) { return a + b; }");
+    function_handle_checks<glua::lua::backend>("lua", "function checked_add(a, b) return a + b end");
+    wrapper_checks();
+    wrapper_identity_checks();
+    jit_info_checks();
+    typed_array_checks();
+    string_checks();
+    map_object_checks();
+    map_read_checks();
+    gc_callback_checks();
+    heap_limit_checks();
+    deadline_checks<glua::spidermonkey::backend>("spidermonkey", "while (true) {}", "while (true) { try { while (true) {} } catch (e) {} }",
+        "function spin(limit) { var x = 0; while (limit === undefined || x < limit) { ++x; } return x; } spin(1000000);", "1");
+    deadline_checks<glua::lua::backend>("lua", "while true do end", "while true do pcall(function() while true do end end) end",
+        "function spin(limit) local x = 0 while limit == nil or x < limit do x = x + 1 end return x end spin(1000000)", "return 1");
+    lua_jit_mode_checks();
+    promise_checks();
+    thread_instance_checks();
+    shared_sandbox_checks();
+    self_hosted_checks();
+    jit_config_checks();
+    sandbox_memory_checks();
+    profiler_checks();
+    sandbox_pool_checks();
+    static_function_checks<glua::spidermonkey::backend>("spidermonkey", "checked_shout(String(checked_multiply(6, 7)))", "checked_multiply(1)");
+    static_function_checks<glua::lua::backend>("lua", "return checked_shout(tostring(checked_multiply(6, 7)))", "return checked_multiply(1)");
+    error_checks();
+    lua_string_view_checks();
+    batch_call_checks<glua::spidermonkey::backend>("spidermonkey", "function checked_add(a, b) { return a + b; }");
+    batch_call_checks<glua::lua::backend>("lua", "function checked_add(a, b) return a + b end");
+
+    std::cout << std::format("{} check(s) failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+}
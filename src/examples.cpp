@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -11,6 +12,8 @@
 #include <glua/backends/lua.hpp>
 #include <glua/backends/spidermonkey.hpp>
 
+#include "checks.hpp"
+
 template <typename... Args>
 void format_print(std::format_string<Args...> fmt, Args&&... args)
 {
@@ -121,6 +124,16 @@ glua::result<void> advanced_test_glua_instance(glua::instance<Backend>& glue)
             };
             return glue.template call_function<void>("print_array", a);
         })
+        .and_then([&]() {
+            // call add once per pair, with the lookup and call setup done once for all of them
+            std::vector<std::tuple<int, int>> pairs { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+            std::vector<int> sums(pairs.size());
+            return glue.template call_function_batch<int>("add", pairs, sums).transform([&]() {
+                for (std::size_t i = 0; i < sums.size(); ++i) {
+                    format_print("Batch call {} of add returned {}\n", i, sums[i]);
+                }
+            });
+        })
         .and_then([&]() {
             // let's call get_weights again, to create another sentinel, but we'll store it in an any and ignore the any
             // despite never using the any the sentinel will destruct when the any destructs, rather than via JS ownership
@@ -139,9 +152,8 @@ glua::result<void> test_glua_instance(std::string input, glua::instance<Backend>
         .and_then([&]() {
             return glue.set_global("magic", 13.37);
         })
+        .and_then([&]() { return glue.template register_class<sentinel>(); })
         .and_then([&]() {
-            glue.template register_class<sentinel>();
-
             return glue.template execute_script<std::string>(input).and_then([&](auto script_result) {
                 format_print("Script completed with result: {}\n", script_result);
                 // check which style of script
@@ -181,6 +193,10 @@ script_type type_for_code(std::string_view code)
 
 int main(int argc, char* argv[])
 {
+    if (argc == 2 && std::string_view { argv[1] } == "--checks") {
+        return checks::run();
+    }
+
     auto [input, type] = [&]() {
         if (argc == 2) {
             std::string filename { argv[1] };
@@ -219,7 +235,7 @@ int main(int argc, char* argv[])
             return glua::instance<glua::spidermonkey::backend>::create().and_then(
                 [&](auto glue) { return test_glua_instance(std::move(input), glue); });
         }
-        return glua::unexpected("no valid script type was determined");
+        return glua::unexpected(glua::error { "no valid script type was determined" });
     }();
 
     if (!total_result.has_value()) {
@@ -6,10 +6,14 @@ extern "C" {
 #include "lauxlib.h"
 #include "lua.h"
 #include "lualib.h"
+#include "luajit.h"
 }
 
+#include <atomic>
 #include <format>
 #include <map>
+#include <span>
+#include <tuple>
 #include <utility>
 
 #include "lua_impl/converter_declarations.hpp"
@@ -67,6 +71,8 @@ public:
     template <typename ReturnType>
     result<ReturnType> execute_script(const std::string& code)
     {
+        static_assert(owning_result<ReturnType>, "Scripts can't return views, return std::string instead");
+
         auto top = lua_gettop(lua_);
         auto retval = [&]() -> result<ReturnType> {
             auto result_code = luaL_loadbuffer(lua_, code.data(),
@@ -78,7 +84,7 @@ public:
                 result_code = lua_pcall(lua_, 0, std::same_as<ReturnType, void> ? 0 : 1, 0);
 
                 if (result_code != 0) {
-                    return unexpected(std::format("Failed to call script: {}", lua_tostring(lua_, -1)));
+                    return unexpected(error::format(error_code::script_failed, "Failed to call script: {}", lua_tostring(lua_, -1)));
                 }
 
                 if constexpr (std::same_as<ReturnType, void>) {
@@ -87,7 +93,7 @@ public:
                     return from_lua<ReturnType>(lua_, -1);
                 }
             } else {
-                return unexpected(std::format("Failed to load script: {}", lua_tostring(lua_, -1)));
+                return unexpected(error::format(error_code::script_failed, "Failed to load script: {}", lua_tostring(lua_, -1)));
             }
         }();
         lua_settop(lua_, top);
@@ -111,9 +117,25 @@ public:
         return {};
     }
 
+    // registers F (a function pointer or captureless lambda) as a plain C function calling it directly
+    template <auto F>
+    result<void> register_function(const std::string& name)
+    {
+        push_env__index();
+        lua_pushstring(lua_, name.data());
+        lua_pushcfunction(lua_, callback_for(create_static_functor<F>()));
+        lua_settable(lua_, -3); // stack was: env__index, name, function
+
+        lua_pop(lua_, 1); // pop env__index back off the stack
+
+        return {};
+    }
+
     template <typename T>
     result<T> get_global(const std::string& name)
     {
+        static_assert(owning_result<T>, "Globals can't be read as views, read std::string instead");
+
         push_env();
         lua_pushstring(lua_, name.data());
 
@@ -144,6 +166,18 @@ public:
         return {};
     }
 
+    template <typename ReturnType>
+    result<ReturnType> execute_script(deadline until, const std::string& code)
+    {
+        return with_deadline(until, [&]() { return execute_script<ReturnType>(code); });
+    }
+
+    template <typename ReturnType, typename... Args>
+    result<ReturnType> call_function(deadline until, const std::string& name, Args&&... args)
+    {
+        return with_deadline(until, [&]() { return call_function<ReturnType>(name, std::forward<Args>(args)...); });
+    }
+
     template <typename ReturnType, typename... Args>
     result<ReturnType> call_function(const std::string& name, Args&&... args)
     {
@@ -157,34 +191,135 @@ public:
         lua_pushvalue(lua_, -2); // env, env["name"], env
         lua_setfenv(lua_, -2); // env, env["name"]
 
-        auto retval = many_push_to_lua(lua_, std::forward<Args>(args)...).and_then([&]() -> result<ReturnType> {
-            // stack now: env, env["name"], args...
-            auto call_result = lua_pcall(lua_, sizeof...(Args), std::same_as<ReturnType, void> ? 0 : 1, 0);
+        auto retval = call_pushed_function<ReturnType>(lua_, std::forward<Args>(args)...);
 
-            if (call_result != 0) {
-                return unexpected(std::format("lua call failed: {}", lua_tostring(lua_, -1)));
-            }
+        // pop off anything leftover, as many_push_to_lua could have failed mid-pushing
+        // so we can't determine the number of items to pop at compile time
+        lua_settop(lua_, starting_top);
 
-            if constexpr (std::same_as<ReturnType, void>) {
-                return {};
-            } else {
-                return from_lua<ReturnType>(lua_, -1);
+        return retval;
+    }
+
+    // calls the function once per element of inputs, writing each call's result to the same index of out.
+    // The function is looked up and given its environment once for the whole batch, and stays on the stack
+    // to be copied for every call. Stops at the first call that fails
+    template <typename ReturnType, typename... Args>
+    result<void> call_function_batch(const std::string& name, std::span<const std::tuple<Args...>> inputs, std::span<ReturnType> out)
+    {
+        if (out.size() < inputs.size()) {
+            return unexpected(error { error_code::invalid_arguments, "Batch output is smaller than its input" });
+        }
+
+        auto starting_top = lua_gettop(lua_);
+
+        push_env(); // env
+        lua_pushstring(lua_, name.data()); // env, "name"
+        lua_gettable(lua_, -2); // env, env["name"]
+
+        if (!lua_isfunction(lua_, -1)) {
+            lua_settop(lua_, starting_top);
+            return unexpected(error::format(error_code::not_found, "No function with the name {} was found", name));
+        }
+
+        lua_pushvalue(lua_, -2); // env, env["name"], env
+        lua_setfenv(lua_, -2); // env, env["name"]
+        auto function_index = lua_gettop(lua_);
+
+        result<void> retval {};
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            lua_pushvalue(lua_, function_index); // env, env["name"], env["name"]
+            auto outcome = std::apply([&](const auto&... args) { return call_pushed_function<ReturnType>(lua_, args...); }, inputs[i])
+                               .transform([&](auto value) { out[i] = std::move(value); });
+
+            // pop off the call's leftovers, which depend on how far it got
+            lua_settop(lua_, function_index);
+
+            if (!outcome.has_value()) {
+                retval = unexpected(error::format(outcome.error().code(), "Batch call {} failed: {}", i, outcome.error()));
+                break;
             }
-        });
+        }
 
-        // pop off anything leftover, as many_push_to_lua could have failed mid-pushing
-        // so we can't determine the number of items to pop at compile time
         lua_settop(lua_, starting_top);
 
         return retval;
     }
 
+    template <typename Signature>
+    class function_handle;
+
+    // a script function resolved once by name and kept alive in the lua registry, which can then be
+    // called repeatedly without looking it up again. The handle must not outlive the backend that created it
+    template <typename ReturnType, typename... ArgTypes>
+    class function_handle<ReturnType(ArgTypes...)> {
+        static_assert(owning_result<ReturnType>, "Script calls can't return views, return std::string instead");
+
+    public:
+        function_handle(lua_State* lua, int ref)
+            : lua_(lua)
+            , ref_(ref)
+        {
+        }
+
+        function_handle(const function_handle&) = delete;
+        function_handle(function_handle&& move)
+            : lua_(move.lua_)
+            , ref_(std::exchange(move.ref_, LUA_NOREF))
+        {
+        }
+
+        ~function_handle()
+        {
+            luaL_unref(lua_, LUA_REGISTRYINDEX, ref_);
+        }
+
+        result<ReturnType> call(ArgTypes... args)
+        {
+            auto starting_top = lua_gettop(lua_);
+
+            lua_rawgeti(lua_, LUA_REGISTRYINDEX, ref_); // function
+            auto retval = call_pushed_function<ReturnType>(lua_, static_cast<ArgTypes&&>(args)...);
+
+            lua_settop(lua_, starting_top);
+
+            return retval;
+        }
+
+    private:
+        lua_State* lua_;
+        int ref_;
+    };
+
+    template <typename Signature>
+    result<function_handle<Signature>> get_function(const std::string& name)
+    {
+        push_env(); // env
+        lua_pushstring(lua_, name.data()); // env, "name"
+        lua_gettable(lua_, -2); // env, env["name"]
+
+        if (!lua_isfunction(lua_, -1)) {
+            lua_pop(lua_, 2);
+            return unexpected(error::format(error_code::not_found, "No function with the name {} was found", name));
+        }
+
+        // the environment sticks to the function, so it only has to be set once
+        lua_pushvalue(lua_, -2); // env, env["name"], env
+        lua_setfenv(lua_, -2); // env, env["name"]
+
+        int ref = luaL_ref(lua_, LUA_REGISTRYINDEX); // env
+        lua_pop(lua_, 1);
+
+        return function_handle<Signature> { lua_, ref };
+    }
+
     template <registered_class T>
-    void register_class()
+    result<void> register_class()
     {
         push_env__index(); // push env__index so registration can add globals if needed
         class_registration_impl<T>::do_registration(lua_);
         lua_pop(lua_, 1); // remove env__index
+
+        return {};
     }
 
     void push_env()
@@ -192,6 +327,19 @@ public:
         lua_getglobal(lua_, current_sandbox_->env_name_.data());
     }
 
+    // turns LuaJIT's compiler on or off for the whole state. Calls with a deadline switch it off for their
+    // duration and put back whatever was set here afterwards
+    void set_jit_enabled(bool enabled)
+    {
+        luaJIT_setmode(lua_, 0, LUAJIT_MODE_ENGINE | (enabled ? LUAJIT_MODE_ON : LUAJIT_MODE_OFF));
+    }
+
+    // whether the compiler is on, as jit.status() reports it
+    bool jit_enabled()
+    {
+        return jit_enabled(lua_);
+    }
+
     void push_env__index()
     {
         lua_getglobal(lua_, current_sandbox_->env__index_name_.data());
@@ -213,6 +361,140 @@ private:
         build_sandbox(start_sandboxed, current_sandbox_);
     }
 
+    // how many VM instructions run between checks of a deadline
+    static constexpr int deadline_check_interval { 1000 };
+
+    static void* deadline_key()
+    {
+        static char key;
+        return &key;
+    }
+
+    // swaps the expired flag of the innermost deadline call, kept in the registry for the hook to find
+    static std::atomic<bool>* swap_deadline_flag(lua_State* lua, std::atomic<bool>* flag)
+    {
+        lua_pushlightuserdata(lua, deadline_key());
+        lua_rawget(lua, LUA_REGISTRYINDEX);
+        auto* previous = static_cast<std::atomic<bool>*>(lua_touserdata(lua, -1));
+        lua_pop(lua, 1);
+
+        lua_pushlightuserdata(lua, deadline_key());
+        lua_pushlightuserdata(lua, flag);
+        lua_rawset(lua, LUA_REGISTRYINDEX);
+        return previous;
+    }
+
+    // installed for the whole of a deadline call, raising an error once the deadline passed. The flag stays
+    // set until the call returns, so a script catching the error with pcall is stopped again straight away
+    static void deadline_hook(lua_State* lua, lua_Debug*)
+    {
+        lua_pushlightuserdata(lua, deadline_key());
+        lua_rawget(lua, LUA_REGISTRYINDEX);
+        auto* expired = static_cast<std::atomic<bool>*>(lua_touserdata(lua, -1));
+        lua_pop(lua, 1);
+
+        if (expired != nullptr && expired->load(std::memory_order_relaxed)) {
+            luaL_error(lua, "deadline exceeded");
+        }
+    }
+
+    // the jit library's status function reports the engine mode, there's no C API for reading it. A state
+    // without the library loaded still runs with LuaJIT's default, on
+    static bool jit_enabled(lua_State* lua)
+    {
+        auto top = lua_gettop(lua);
+        bool enabled { true };
+
+        lua_getfield(lua, LUA_REGISTRYINDEX, "_LOADED");
+        if (lua_istable(lua, -1)) {
+            lua_getfield(lua, -1, "jit");
+            if (lua_istable(lua, -1)) {
+                lua_getfield(lua, -1, "status");
+                enabled = lua_pcall(lua, 0, 1, 0) == 0 && lua_toboolean(lua, -1);
+            }
+        }
+
+        lua_settop(lua, top);
+        return enabled;
+    }
+
+    // runs call, interrupting the script it runs if it's still going once until passes. Compiled traces
+    // never call hooks, so the compiler is switched off for the call and the function it calls has its
+    // traces flushed (see call_pushed_function). The mode and any hook the host had set are put back after
+    template <typename Call>
+    auto with_deadline(deadline until, Call&& call)
+    {
+        std::atomic<bool> expired { false };
+        auto* outer = swap_deadline_flag(lua_, &expired);
+
+        bool jit_was_enabled { false };
+        lua_Hook host_hook { nullptr };
+        int host_hook_mask { 0 };
+        int host_hook_count { 0 };
+        if (outer == nullptr) {
+            jit_was_enabled = jit_enabled(lua_);
+            host_hook = lua_gethook(lua_);
+            host_hook_mask = lua_gethookmask(lua_);
+            host_hook_count = lua_gethookcount(lua_);
+
+            if (jit_was_enabled) {
+                luaJIT_setmode(lua_, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+            }
+            lua_sethook(lua_, &deadline_hook, LUA_MASKCOUNT, deadline_check_interval);
+        }
+
+        auto retval = [&]() {
+            // the watchdog thread only sets the flag, the lua state is only touched from this thread
+            auto guard = watchdog::get().watch(until, [&]() { expired.store(true, std::memory_order_relaxed); });
+            return call();
+        }();
+
+        swap_deadline_flag(lua_, outer);
+        if (outer == nullptr) {
+            lua_sethook(lua_, host_hook, host_hook_mask, host_hook_count);
+            if (jit_was_enabled) {
+                luaJIT_setmode(lua_, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
+            }
+        }
+
+        if (expired.load(std::memory_order_relaxed)) {
+            if (!retval.has_value()) {
+                retval = unexpected(error { error_code::deadline_exceeded, "Script call exceeded its deadline" });
+            }
+        }
+
+        return retval;
+    }
+
+    // expects the function on top of the stack, the caller is responsible for restoring the stack
+    template <typename ReturnType, typename... Args>
+    static result<ReturnType> call_pushed_function(lua_State* lua, Args&&... args)
+    {
+        // the result is read off the stack the caller pops, so a view into it would dangle
+        static_assert(owning_result<ReturnType>, "Script calls can't return views, return std::string instead");
+
+        // under a deadline, the function's own traces (and those of functions nested in it) would run
+        // without checking the hook. Only they are flushed, traces elsewhere in the state are kept
+        if (lua_gethook(lua) == &deadline_hook) {
+            luaJIT_setmode(lua, -1, LUAJIT_MODE_ALLFUNC | LUAJIT_MODE_FLUSH);
+        }
+
+        return many_push_to_lua(lua, std::forward<Args>(args)...).and_then([&]() -> result<ReturnType> {
+            // stack now: function, args...
+            auto call_result = lua_pcall(lua, sizeof...(Args), std::same_as<ReturnType, void> ? 0 : 1, 0);
+
+            if (call_result != 0) {
+                return unexpected(error::format(error_code::script_failed, "lua call failed: {}", lua_tostring(lua, -1)));
+            }
+
+            if constexpr (std::same_as<ReturnType, void>) {
+                return {};
+            } else {
+                return from_lua<ReturnType>(lua, -1);
+            }
+        });
+    }
+
     void build_sandbox(bool start_sandboxed, sandbox* s)
     {
         if (start_sandboxed) {
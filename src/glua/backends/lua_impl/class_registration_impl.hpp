@@ -75,10 +75,10 @@ struct class_registration_impl {
             if (data->mutable_) {
                 return static_cast<T*>(data->ptr_);
             } else {
-                return unexpected("unwrap failed - attempted to extract mutable reference to const object");
+                return unexpected(error { error_code::conversion_failed, "unwrap failed - attempted to extract mutable reference to const object" });
             }
         } else {
-            return unexpected("unwrap on non-object value");
+            return unexpected(error { error_code::conversion_failed, "unwrap on non-object value" });
         }
     }
 
@@ -88,7 +88,7 @@ struct class_registration_impl {
             auto* data = static_cast<class_registration_data_ptr*>(lua_touserdata(lua, i))->get();
             return static_cast<const T*>(data->ptr_);
         } else {
-            return unexpected("unwrap on non-object value");
+            return unexpected(error { error_code::conversion_failed, "unwrap on non-object value" });
         }
     }
 
@@ -172,11 +172,11 @@ struct class_registration_impl {
                 return push_to_lua(lua, self.*field.field_ptr_).transform([&]() { return 1; }); // 1 item pushed to stack
             });
         }(std::get<FieldIndex>(registration::fields))
-                   .or_else([&](const std::string& error) -> result<int> {
-                       lua_pushstring(lua, error.data());
+                   .or_else([&](const auto& error) -> result<int> {
+                       lua_pushstring(lua, error.c_str());
                        lua_error(lua);
 
-                       return unexpected("lua: unreachable post lua_error code reached");
+                       return unexpected(glua::error { "lua: unreachable post lua_error code reached" });
                    })
                    .value();
     }
@@ -189,7 +189,7 @@ struct class_registration_impl {
             return from_lua<T&>(lua, 1).and_then([&](T& self) -> result<int> {
                 return from_lua<V>(lua, 3).and_then([&](V value) -> result<int> {
                     if constexpr (std::is_const_v<V>) {
-                        return unexpected("lua: attempt to set const field");
+                        return unexpected(error { error_code::invalid_arguments, "lua: attempt to set const field" });
                     } else {
                         (self.*field.field_ptr_) = std::move(value);
                     }
@@ -198,11 +198,11 @@ struct class_registration_impl {
                 });
             });
         }(std::get<FieldIndex>(registration::fields))
-                   .or_else([&](const std::string& error) -> result<int> {
-                       lua_pushstring(lua, error.data());
+                   .or_else([&](const auto& error) -> result<int> {
+                       lua_pushstring(lua, error.c_str());
                        lua_error(lua);
 
-                       return unexpected("lua: unreachable post lua_error code reached");
+                       return unexpected(glua::error { "lua: unreachable post lua_error code reached" });
                    })
                    .value();
     }
@@ -223,14 +223,14 @@ struct class_registration_impl {
                                                 if (pos != index_handlers.end()) {
                                                     return pos->second(lua);
                                                 } else {
-                                                    return unexpected(std::format("no field or method '{}'", value));
+                                                    return unexpected(error::format(error_code::not_found, "no field or method '{}'", value));
                                                 }
                                             })
-            .or_else([&](const std::string& error) -> result<int> {
-                lua_pushstring(lua, error.data());
+            .or_else([&](const auto& error) -> result<int> {
+                lua_pushstring(lua, error.c_str());
                 lua_error(lua);
 
-                return unexpected("lua: unreachable post lua_error code reached");
+                return unexpected(glua::error { "lua: unreachable post lua_error code reached" });
             })
             .value();
     }
@@ -243,14 +243,14 @@ struct class_registration_impl {
                                                 if (pos != newindex_handlers.end()) {
                                                     return pos->second(lua);
                                                 } else {
-                                                    return unexpected(std::format("no field or method '{}'", value));
+                                                    return unexpected(error::format(error_code::not_found, "no field or method '{}'", value));
                                                 }
                                             })
-            .or_else([&](const std::string& error) -> result<int> {
-                lua_pushstring(lua, error.data());
+            .or_else([&](const auto& error) -> result<int> {
+                lua_pushstring(lua, error.c_str());
                 lua_error(lua);
 
-                return unexpected("lua: unreachable post lua_error code reached");
+                return unexpected(glua::error { "lua: unreachable post lua_error code reached" });
             })
             .value();
     }
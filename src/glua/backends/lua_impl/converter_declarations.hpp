@@ -35,7 +35,10 @@ template <decays_to<std::string_view> T>
 struct converter<T> {
     static result<void> push_to_lua(lua_State* lua, std::string_view v);
 
-    // from_lua not supported, can't 'point' to script bytes
+    // views the string on the stack, which lua keeps alive and in place while it's there. That makes it
+    // only usable for bound function parameters, valid until the functor returns. Scripts, globals and
+    // script calls reject view results at compile time, as their value is popped before it's returned
+    static result<std::string_view> from_lua(lua_State* lua, int i);
 };
 
 template <decays_to<const char*> T>
@@ -231,11 +234,9 @@ result<void> many_push_to_lua(lua_State* lua, T&& value, Ts&&... values);
 
 result<void> many_push_to_lua(lua_State* lua);
 
-template <typename T>
-using IndexFor = lua_Integer;
-
-template <typename... Ts>
-auto many_from_lua([[maybe_unused]] lua_State* lua, IndexFor<Ts>... vs);
+// converts the stack values from first + I onwards to the remaining Ts and calls f with everything converted so far
+template <typename R, std::size_t I, typename... Ts, typename F, typename... Converted>
+R apply_from_lua(lua_State* lua, int first, F&& f, Converted&&... converted);
 
 ////////////////////////////////////////////////////////////////////
 // THESE HELPERS MUST ALWAYS BE THE LAST DEFINITIONS IN THIS FILE //
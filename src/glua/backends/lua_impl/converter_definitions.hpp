@@ -18,19 +18,29 @@ result<std::string> converter<T>::from_lua(lua_State* lua, int i)
     if (str) {
         return std::string { str };
     } else {
-        return unexpected("lua value could not be converted to string");
+        return unexpected(error { error_code::conversion_failed, "lua value could not be converted to string" });
     }
 }
 
 template <decays_to<std::string_view> T>
 result<void> converter<T>::push_to_lua(lua_State* lua, std::string_view v)
 {
-    // needs to be null terminated, so we need a copy
-    std::string copy { v };
-    lua_pushstring(lua, copy.data());
+    lua_pushlstring(lua, v.data(), v.size());
     return {};
 }
 
+template <decays_to<std::string_view> T>
+result<std::string_view> converter<T>::from_lua(lua_State* lua, int i)
+{
+    std::size_t length { 0 };
+    const char* str = lua_tolstring(lua, i, &length);
+    if (str) {
+        return std::string_view { str, length };
+    } else {
+        return unexpected(error { error_code::conversion_failed, "lua value could not be converted to string" });
+    }
+}
+
 template <decays_to<const char*> T>
 result<void> converter<T>::push_to_lua(lua_State* lua, const char* v)
 {
@@ -105,7 +115,7 @@ result<std::vector<T>> converter<std::vector<T>>::from_lua(lua_State* lua, int i
 
         return result;
     } else {
-        return unexpected("Could not convert non-table to vector");
+        return unexpected(error { error_code::conversion_failed, "Could not convert non-table to vector" });
     }
 }
 
@@ -185,7 +195,7 @@ result<std::unordered_map<std::string, T>> converter<std::unordered_map<std::str
 
         return result;
     } else {
-        return unexpected("Could not convert non-table to unordered_map");
+        return unexpected(error { error_code::conversion_failed, "Could not convert non-table to unordered_map" });
     }
 }
 
@@ -400,7 +410,7 @@ inline result<void> converter<any>::push_to_lua(lua_State* lua, const any& v)
     if (lua_any) {
         return lua_any->push_to_lua(lua);
     } else {
-        return unexpected("Received invalid any, perhaps from another backend");
+        return unexpected(error { error_code::conversion_failed, "Received invalid any, perhaps from another backend" });
     }
 }
 
@@ -460,7 +470,7 @@ inline result<any> converter<any>::from_lua(lua_State* lua, int i)
             return data->get()->make_any_(data);
         }
         }
-        return unexpected("Cannot create any from invalid typed lua item");
+        return unexpected(error { error_code::conversion_failed, "Cannot create any from invalid typed lua item" });
     }()
                         .transform([&](auto any_ptr) {
                             return any { std::move(any_ptr) };
@@ -490,10 +500,21 @@ result<void> many_push_to_lua(lua_State* lua, T&& value, Ts&&... values)
 
 inline result<void> many_push_to_lua(lua_State*) { return {}; }
 
-template <typename... Ts>
-auto many_from_lua([[maybe_unused]] lua_State* lua, IndexFor<Ts>... vs)
+// each argument is converted in place, one recursion level each, and reaches f as a reference to the value
+// in its level's result. Nothing is gathered into a tuple of results or moved into a tuple of values, and
+// the first failure returns without converting the rest
+template <typename R, std::size_t I, typename... Ts, typename F, typename... Converted>
+R apply_from_lua(lua_State* lua, int first, F&& f, Converted&&... converted)
 {
-    auto many_expected = std::make_tuple(from_lua<Ts>(lua, vs)...);
-    return many_results_to_one(std::move(many_expected));
+    if constexpr (I == sizeof...(Ts)) {
+        return static_cast<F&&>(f)(static_cast<Converted&&>(converted)...);
+    } else {
+        auto arg = from_lua<std::tuple_element_t<I, std::tuple<Ts...>>>(lua, first + static_cast<int>(I));
+        if (!arg.has_value()) {
+            return unexpected(std::move(arg).error());
+        }
+
+        return apply_from_lua<R, I + 1, Ts...>(lua, first, static_cast<F&&>(f), static_cast<Converted&&>(converted)..., std::move(arg).value());
+    }
 }
 }
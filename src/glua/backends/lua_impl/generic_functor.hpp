@@ -5,37 +5,40 @@
 
 namespace glua::lua {
 
-template <typename ReturnType, typename... ArgTypes>
-int call_generic_wrapped_functor(generic_functor<ReturnType, ArgTypes...>& f, lua_State* lua)
+// Functor is anything with a call(ArgTypes...) member, i.e. a generic_functor or a static_functor
+template <typename ReturnType, typename... ArgTypes, typename Functor>
+int call_wrapped_functor(Functor& f, lua_State* lua)
 {
     int stack_size = lua_gettop(lua);
     if (std::cmp_less(stack_size, sizeof...(ArgTypes))) {
         auto error = std::format("incorrect number of arguments, stack_size {}, args {}", stack_size, sizeof...(ArgTypes));
-        lua_pushstring(lua, error.data()); //"incorrect number of arguments");
+        lua_pushstring(lua, error.c_str()); //"incorrect number of arguments");
         lua_error(lua); // throws, no return
     }
 
-    return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-        // first arg is at index 1
-        return many_from_lua<ArgTypes...>(lua, (1 + Is)...).and_then([&](auto args) -> result<int> {
-            if constexpr (std::same_as<ReturnType, void>) {
-                std::apply(
-                    [&](auto&&... unwrapped_args) { f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...); }, std::move(args));
-
-                return 0;
-            } else {
-                return push_to_lua(lua, std::apply([&](auto&&... unwrapped_args) -> ReturnType { return f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...); }, std::move(args)))
-                    .transform([]() { return 1; }); // 1 for 1 return value
-            }
-        });
-    }(std::index_sequence_for<ArgTypes...> {})
-               .or_else([&](const auto& error) -> result<int> {
-                   lua_pushstring(lua, error.data());
-                   lua_error(lua);
-
-                   return unexpected("lua: unreachable post lua_error code reached");
-               })
-               .value();
+    // first arg is at index 1
+    auto outcome = apply_from_lua<result<int>, 0, ArgTypes...>(lua, 1, [&](auto&&... unwrapped_args) -> result<int> {
+        if constexpr (std::same_as<ReturnType, void>) {
+            f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
+            return 0;
+        } else {
+            return push_to_lua(lua, f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...))
+                .transform([]() { return 1; }); // 1 for 1 return value
+        }
+    });
+
+    if (!outcome.has_value()) {
+        lua_pushstring(lua, outcome.error().c_str());
+        lua_error(lua); // throws, no return
+    }
+
+    return outcome.value();
+}
+
+template <typename ReturnType, typename... ArgTypes>
+int call_generic_wrapped_functor(generic_functor<ReturnType, ArgTypes...>& f, lua_State* lua)
+{
+    return call_wrapped_functor<ReturnType, ArgTypes...>(f, lua);
 }
 
 template <typename ReturnType, typename... ArgTypes>
@@ -51,4 +54,17 @@ auto callback_for(const generic_functor<ReturnType, ArgTypes...>&)
 {
     return &generic_wrapped_functor<ReturnType, ArgTypes...>;
 }
+
+template <auto F, typename ReturnType, typename... ArgTypes>
+int static_wrapped_functor(lua_State* lua)
+{
+    static_functor<F, ReturnType, ArgTypes...> f;
+    return call_wrapped_functor<ReturnType, ArgTypes...>(f, lua);
+}
+
+template <auto F, typename ReturnType, typename... ArgTypes>
+auto callback_for(const static_functor<F, ReturnType, ArgTypes...>&)
+{
+    return &static_wrapped_functor<F, ReturnType, ArgTypes...>;
+}
 }
@@ -2,21 +2,64 @@
 
 #include "glua/glua.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
 #include <format>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <thread>
+#include <variant>
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
 #include <js/Array.h>
+#include <js/ArrayBuffer.h>
+#include <js/BuildId.h>
 #include <js/CallArgs.h>
 #include <js/CompilationAndEvaluation.h>
 #include <js/Conversions.h>
+#include <js/GCAPI.h>
 #include <js/ErrorInterceptor.h>
 #include <js/Initialization.h>
+#include <js/MemoryMetrics.h>
 #include <js/Object.h>
+#include <js/OffThreadScriptCompilation.h>
+#include <js/Promise.h>
+#include <js/ProfilingCategory.h>
+#include <js/ProfilingFrameIterator.h>
+#include <js/ProfilingStack.h>
+#include <js/PropertyAndElement.h>
 #include <js/RootingAPI.h>
+#include <js/ScalarType.h>
+#include <js/SliceBudget.h>
 #include <js/SourceText.h>
+#include <js/String.h>
+#include <js/Transcoding.h>
 #include <js/Value.h>
+#include <js/experimental/JSStencil.h>
+#include <js/experimental/TypedData.h>
+#include <js/friend/StableStringChars.h>
 
 // get declarations first
 #include "spidermonkey_impl/converter_declarations.hpp"
@@ -24,7 +67,13 @@
 // any implementations depend on converter declarations
 #include "spidermonkey_impl/any.hpp"
 
-// class_registration_impl depends on converters and any
+// per-context state, only depends on spidermonkey itself
+#include "spidermonkey_impl/context_data.hpp"
+
+// depends on context_data
+#include "spidermonkey_impl/profiler.hpp"
+
+// class_registration_impl depends on converters, any, context_data and profiler
 #include "spidermonkey_impl/class_registration_impl.hpp"
 
 // some definitions depend on converter declarations, but some depend on class_registration_impl
@@ -33,13 +82,59 @@
 // depends on all conversion utilities
 #include "spidermonkey_impl/generic_functor.hpp"
 
+// only depends on spidermonkey itself
+#include "spidermonkey_impl/script_cache.hpp"
+
+// only depends on spidermonkey itself
+#include "spidermonkey_impl/memory_stats.hpp"
+
 namespace glua::spidermonkey {
+// zero or unset values keep spidermonkey's defaults
+struct backend_options {
+    // the most the GC heap of this instance may grow to, allocations beyond it fail the running call
+    // with an out of memory error instead of growing further
+    uint32_t max_heap_bytes { 0 };
+
+    // size limit of the nursery, where new objects are allocated and collected cheaply by minor GCs
+    uint32_t max_nursery_bytes { 0 };
+
+    // incremental collection splits a major GC into slices interleaved with script execution
+    bool incremental_gc { true };
+
+    // the time each slice of an incremental collection may take
+    std::chrono::milliseconds gc_slice_budget { 0 };
+
+    // debug builds of spidermonkey can be told to collect constantly through the JS_GC_ZEAL environment
+    // variable, which is turned off unless this is set
+    bool allow_gc_zeal { false };
+
+    // the JIT tiers a script moves through as it warms up, each warmup being the number of function calls
+    // and loop iterations before the tier is used. Spidermonkey keeps these process-wide, so they apply to
+    // every instance and the most recently created instance's values win
+    std::optional<bool> baseline_interpreter_enabled;
+    std::optional<uint32_t> baseline_interpreter_warmup;
+    std::optional<bool> baseline_jit_enabled;
+    std::optional<uint32_t> baseline_jit_warmup;
+    std::optional<bool> ion_enabled;
+    std::optional<uint32_t> ion_warmup;
+};
+
+// the JIT configuration in effect
+struct jit_config {
+    bool baseline_interpreter_enabled_;
+    uint32_t baseline_interpreter_warmup_;
+    bool baseline_jit_enabled_;
+    uint32_t baseline_jit_warmup_;
+    bool ion_enabled_;
+    uint32_t ion_warmup_;
+};
+
 class backend {
 public:
-    static result<std::unique_ptr<backend>> create()
+    static result<std::unique_ptr<backend>> create(backend_options options = {})
     {
         return do_global_init().and_then([&]() {
-            return create_context().and_then([&](auto context) {
+            return create_context(options).and_then([&](auto context) {
                 return create_global_scope(context.value_).transform([&](auto* global_scope) {
                     return std::unique_ptr<backend> { new backend { std::move(context), global_scope } };
                 });
@@ -49,35 +144,56 @@ public:
 
     struct sandbox {
         sandbox(JSContext* cx, JSObject* obj)
-            : scope_(cx, obj)
+            : cx_(cx)
+            , scope_(cx, obj)
             , owner_(true)
         {
         }
 
         sandbox(const sandbox&) = delete;
         sandbox(sandbox&& move)
-            : scope_(std::move(move.scope_))
+            : cx_(move.cx_)
+            , scope_(std::move(move.scope_))
             , owner_(std::exchange(move.owner_, false))
         {
         }
 
         ~sandbox()
         {
-            if (owner_)
+            if (owner_) {
+                get_context_data(cx_).release_realm(JS::GetObjectRealmOrNull(scope_));
                 scope_.reset();
+            }
         }
 
+        JSContext* cx_;
         JS::PersistentRootedObject scope_;
         bool owner_;
     };
 
-    result<sandbox> create_sandbox()
+    // a sandbox normally gets a compartment of its own, and objects passed between it and other sandboxes go
+    // through cross-compartment wrappers. A shared sandbox is created in the compartment of the default scope
+    // instead, which is much cheaper to create and passes objects directly, but only isolates the globals:
+    // an object handed across remains fully accessible to both sides
+    enum class sandbox_compartment {
+        separate,
+        shared
+    };
+
+    result<sandbox> create_sandbox(sandbox_compartment compartment = sandbox_compartment::separate)
     {
-        return create_global_scope(cx_.value_).transform([&](auto* obj) {
+        JS::RealmOptions options;
+        if (compartment == sandbox_compartment::shared) {
+            options.creationOptions().setExistingCompartment(global_scope_.get());
+        }
+
+        return create_global_scope(cx_.value_, options).transform([&](auto* obj) {
             return sandbox { cx_.value_, obj };
         });
     }
 
+    class sandbox_pool;
+
     void set_active_sandbox(sandbox* sandbox)
     {
         if (sandbox == nullptr) {
@@ -87,32 +203,307 @@ public:
         }
     }
 
+    // a script compiled ahead of time, which can be executed any number of times in any sandbox
+    struct compiled_script {
+        RefPtr<JS::Stencil> stencil_;
+    };
+
     template <typename ReturnType>
     result<ReturnType> execute_script(const std::string& code)
     {
         JSAutoRealm auto_realm { cx_.value_, current_scope_ };
 
-        JS::SourceText<mozilla::Utf8Unit> source;
-        if (!source.init(cx_.value_, code.data(), code.size(), JS::SourceOwnership::Borrowed)) {
-            return unexpected("Spidermonkey failed to init source\n");
-        }
+        JS::RootedScript compiled_script { cx_.value_ };
+        return compile_script(code, &compiled_script).and_then([&]() { return run_script<ReturnType>(compiled_script); });
+    }
+
+    template <typename ReturnType>
+    result<ReturnType> execute_script(deadline until, const std::string& code)
+    {
+        return with_deadline(until, [&]() { return execute_script<ReturnType>(code); });
+    }
+
+    template <typename ReturnType>
+    result<ReturnType> execute_script(const compiled_script& script)
+    {
+        JSAutoRealm auto_realm { cx_.value_, current_scope_ };
+
+        JS::RootedScript instantiated_script { cx_.value_ };
+        return instantiate_stencil(script.stencil_, &instantiated_script).and_then([&]() {
+            return run_script<ReturnType>(instantiated_script);
+        });
+    }
+
+    // compiles every source in parallel on spidermonkey's helper threads, returning once all of them
+    // have finished. The results are in the same order as sources and are executed with execute_script
+    result<std::vector<compiled_script>> compile_scripts(std::span<const std::string> sources)
+    {
+        JSAutoRealm auto_realm { cx_.value_, current_scope_ };
 
         JS::CompileOptions compile_options { cx_.value_ };
         compile_options.setFileAndLine("inline", 1);
 
-        JS::RootedScript compiled_script { cx_.value_, JS::Compile(cx_.value_, compile_options, source) };
-        if (compiled_script == nullptr) {
-            return unexpected("Spidermonkey failed to compile script\n");
+        struct pending_compile {
+            std::size_t index_;
+            JS::SourceText<mozilla::Utf8Unit> source_;
+            JS::OffThreadToken* token_ { nullptr };
+        };
+
+        struct batch_state {
+            static void on_compiled(JS::OffThreadToken*, void* data)
+            {
+                // notified under the lock, the waiting thread owns the state and may destroy it as soon as
+                // it can observe outstanding_ reach zero
+                auto* state = static_cast<batch_state*>(data);
+                std::lock_guard lock { state->mutex_ };
+                --state->outstanding_;
+                state->done_.notify_one();
+            }
+
+            std::mutex mutex_;
+            std::condition_variable done_;
+            std::size_t outstanding_ { 0 };
+        };
+
+        std::vector<compiled_script> compiled(sources.size());
+        std::vector<std::unique_ptr<pending_compile>> pending;
+        std::vector<std::size_t> synchronous;
+        batch_state state;
+
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            const auto& code = sources[i];
+            if (script_cache_) {
+                if (auto stencil = script_cache_->load(cx_.value_, compile_options, code)) {
+                    compiled[i].stencil_ = std::move(stencil);
+                    continue;
+                }
+            }
+
+            // spidermonkey declines tiny scripts, which are cheaper to compile than to hand off
+            if (!JS::CanCompileOffThread(cx_.value_, compile_options, code.size())) {
+                synchronous.push_back(i);
+                continue;
+            }
+
+            auto compile = std::make_unique<pending_compile>();
+            compile->index_ = i;
+            if (!compile->source_.init(cx_.value_, code.data(), code.size(), JS::SourceOwnership::Borrowed)) {
+                synchronous.push_back(i);
+                continue;
+            }
+
+            {
+                std::lock_guard lock { state.mutex_ };
+                ++state.outstanding_;
+            }
+            compile->token_ = JS::CompileToStencilOffThread(cx_.value_, compile_options, compile->source_, &batch_state::on_compiled, &state);
+            if (compile->token_ == nullptr) {
+                {
+                    std::lock_guard lock { state.mutex_ };
+                    --state.outstanding_;
+                }
+                JS_ClearPendingException(cx_.value_);
+                synchronous.push_back(i);
+                continue;
+            }
+
+            pending.push_back(std::move(compile));
         }
 
-        JS::RootedValue return_value { cx_.value_ };
-        if (!JS_ExecuteScript(cx_.value_, compiled_script, &return_value)) {
-            return unexpected("Spidermonkey failed to execute script\n");
+        // the calling thread contributes by compiling whatever couldn't be handed off
+        result<void> outcome {};
+        for (auto i : synchronous) {
+            auto stencil = compile_stencil(compile_options, sources[i]);
+            if (!stencil.has_value()) {
+                outcome = unexpected(std::move(stencil).error());
+                break;
+            }
+            compiled[i].stencil_ = std::move(stencil).value();
         }
 
-        if constexpr (!std::same_as<ReturnType, void>) {
-            return from_js<ReturnType>(cx_.value_, return_value);
+        {
+            std::unique_lock lock { state.mutex_ };
+            state.done_.wait(lock, [&]() { return state.outstanding_ == 0; });
+        }
+
+        // every token must be finished, even after a failure, or its resources leak
+        for (auto& compile : pending) {
+            RefPtr<JS::Stencil> stencil = JS::FinishOffThreadStencil(cx_.value_, compile->token_);
+            if (!stencil) {
+                if (outcome.has_value()) {
+                    outcome = engine_failure(cx_.value_, "Spidermonkey failed to compile script {} of batch\n", compile->index_);
+                }
+                continue;
+            }
+
+            if (script_cache_) {
+                script_cache_->store(cx_.value_, sources[compile->index_], stencil);
+            }
+            compiled[compile->index_].stencil_ = std::move(stencil);
+        }
+
+        return outcome.transform([&]() { return std::move(compiled); });
+    }
+
+    // compiled scripts are cached as XDR-encoded stencils in directory, and later compiles of the same
+    // source (including in later processes) decode the cached stencil instead of parsing again. The least
+    // recently used entries are removed once the directory holds more than max_bytes
+    result<void> enable_script_cache(std::filesystem::path directory, std::uintmax_t max_bytes = script_cache::default_max_bytes)
+    {
+        return script_cache::create(std::move(directory), max_bytes).transform([&](auto cache) {
+            script_cache_.emplace(std::move(cache));
+        });
+    }
+
+    void disable_script_cache() { script_cache_.reset(); }
+
+    // nullopt while the script cache is disabled
+    std::optional<script_cache_stats> get_script_cache_stats() const
+    {
+        if (!script_cache_) {
+            return std::nullopt;
+        }
+
+        return script_cache_->stats();
+    }
+
+    // performs up to budget worth of garbage collection work, starting a new incremental collection if
+    // none is in progress. Returns true once the collection has finished, so an idle loop can keep
+    // calling this until it does, and major collections happen in the idle time instead of mid-request
+    bool collect_garbage_slice(std::chrono::milliseconds budget)
+    {
+        js::SliceBudget slice_budget { js::TimeBudget { budget.count() } };
+        if (JS::IsIncrementalGCInProgress(cx_.value_)) {
+            JS::PrepareForIncrementalGC(cx_.value_);
+            JS::IncrementalGCSlice(cx_.value_, JS::GCReason::API, slice_budget);
+        } else {
+            JS::PrepareForFullGC(cx_.value_);
+            JS::StartIncrementalGC(cx_.value_, JS::GCOptions::Normal, JS::GCReason::API, slice_budget);
+        }
+
+        context_data_->deliver_memory_pressure();
+        return !JS::IsIncrementalGCInProgress(cx_.value_);
+    }
+
+    // settles the promises of futures which have become ready, then runs queued jobs (promise reactions,
+    // the continuations of async functions). Returns how many futures are still outstanding, so an event
+    // loop knows whether it needs to keep calling this
+    std::size_t run_pending_jobs()
+    {
+        auto& pending = context_data_->pending_settlements_;
+        std::erase_if(pending, [&](auto& settlement) { return settlement->try_settle(cx_.value_); });
+
+        js::RunJobs(cx_.value_);
+
+        return pending.size();
+    }
+
+    // the JIT tiers and warmup thresholds in effect, read without touching the heap
+    jit_config get_jit_config() const
+    {
+        auto get_jit_option = [&](JSJitCompilerOption option) {
+            uint32_t value { 0 };
+            JS_GetGlobalJitCompilerOption(cx_.value_, option, &value);
+            return value;
+        };
+
+        return jit_config {
+            get_jit_option(JSJITCOMPILER_BASELINE_INTERPRETER_ENABLE) != 0,
+            get_jit_option(JSJITCOMPILER_BASELINE_INTERPRETER_WARMUP_TRIGGER),
+            get_jit_option(JSJITCOMPILER_BASELINE_ENABLE) != 0,
+            get_jit_option(JSJITCOMPILER_BASELINE_WARMUP_TRIGGER),
+            get_jit_option(JSJITCOMPILER_ION_ENABLE) != 0,
+            get_jit_option(JSJITCOMPILER_ION_NORMAL_WARMUP_TRIGGER),
+        };
+    }
+
+    // a snapshot of the memory each JIT tier holds, not a measure of JIT activity. It walks the whole heap
+    // and finishes any incremental collection in progress first, so it's a diagnostic to take occasionally
+    // rather than something to poll
+    result<jit_memory> get_jit_memory_snapshot()
+    {
+        return runtime_stats::collect(cx_.value_).transform([&](auto stats) {
+            return jit_memory {
+                stats->realmTotals.jitScripts,
+                stats->realmTotals.baselineData,
+                stats->realmTotals.ionData,
+            };
+        });
+    }
+
+    // the GC heap bytes of the zone holding each of sandboxes, where nullptr is the default scope. Read from
+    // the collector's own per-zone counters, so it is cheap enough to sample per request and never disturbs
+    // an incremental collection. Sandboxes sharing a compartment share a zone, and each reports its total
+    std::vector<std::size_t> get_sandbox_memory(std::span<const sandbox* const> sandboxes) const
+    {
+        std::vector<std::size_t> memory;
+        memory.reserve(sandboxes.size());
+        for (const auto* s : sandboxes) {
+            memory.push_back(js::GetGCHeapUsageForObjectZone(s != nullptr ? s->scope_.get() : global_scope_.get()));
+        }
+        return memory;
+    }
+
+    // a breakdown of the memory used by each of sandboxes (nullptr being the default scope) into GC heap,
+    // malloc'd, script and JIT data. One walk of the whole heap measures every sandbox, and the walk finishes
+    // any incremental collection in progress first, so this is a diagnostic to take occasionally
+    result<std::vector<sandbox_memory>> get_sandbox_memory_report(std::span<const sandbox* const> sandboxes)
+    {
+        return runtime_stats::collect(cx_.value_).transform([&](auto stats) {
+            std::vector<sandbox_memory> memory;
+            memory.reserve(sandboxes.size());
+            for (const auto* s : sandboxes) {
+                memory.push_back(stats->memory_of(s != nullptr ? s->scope_.get() : global_scope_.get()));
+            }
+            return memory;
+        });
+    }
+
+    // samples the stacks of running scripts every interval until stop_profiling, each sample covering
+    // both the JS functions and the registered C++ functors and methods being run. Profiling must only be
+    // started and stopped while no script is running
+    void start_profiling(std::chrono::microseconds interval = std::chrono::milliseconds { 1 })
+    {
+        profiler_.reset();
+        profiler_ = std::make_unique<profiler>(cx_.value_, interval);
+    }
+
+    // returns the samples taken as folded stacks, one "outer;inner count" line per distinct stack, which
+    // flame graph tools read directly
+    std::string stop_profiling()
+    {
+        if (!profiler_) {
+            return {};
         }
+
+        auto folded = profiler_->folded_stacks();
+        profiler_.reset();
+        return folded;
+    }
+
+    // a complete, non-incremental collection
+    void collect_garbage()
+    {
+        JS_GC(cx_.value_, JS::GCReason::API);
+        context_data_->deliver_memory_pressure();
+    }
+
+    // called at the start and end of every collection and of each of its slices, pass an empty
+    // function to remove it. It runs inside the collector, so it must not allocate GC things, run
+    // scripts or otherwise call into the backend, only record what happened
+    void set_gc_callback(std::function<void(gc_progress)> callback) { context_data_->gc_callback_ = std::move(callback); }
+
+    // bytes currently allocated on the GC heap, against the limit it may grow to
+    heap_usage get_heap_usage() const { return context_data::get_heap_usage(cx_.value_); }
+
+    // called after a collection which left the heap at or above threshold (a fraction of the limit),
+    // giving the host the chance to shed load before allocations start failing. It is deferred until the
+    // collection is over: it runs when collect_garbage or collect_garbage_slice returns, or at the next
+    // interrupt check of a running script, where it may use the backend
+    void set_memory_pressure_callback(double threshold, std::function<void(heap_usage)> callback)
+    {
+        context_data_->memory_pressure_threshold_ = threshold;
+        context_data_->memory_pressure_callback_ = std::move(callback);
     }
 
     template <typename ReturnType, typename... ArgTypes>
@@ -127,18 +518,39 @@ public:
                 cx_.value_, scope, name.data(), callback_for(functor), functor.num_args, 0)
         };
         if (js_func == nullptr) {
-            return unexpected(std::format("Spidermonkey failed to define function"));
+            return engine_failure(cx_.value_, "Spidermonkey failed to define function");
         }
 
         auto* obj = JS_GetFunctionObject(js_func);
         js::SetFunctionNativeReserved(obj, 0, JS::PrivateValue(&functor));
 
+        // the name labels the functor's calls when profiling, it's stored in the context so it outlives the function
+        const auto& stored_name = context_data_->functor_names_.emplace(&functor, name).first->second;
+        js::SetFunctionNativeReserved(obj, 1, JS::PrivateValue(const_cast<char*>(stored_name.data())));
+
+        return {};
+    }
+
+    // registers F (a function pointer or captureless lambda) with a native trampoline calling it directly
+    template <auto F>
+    result<void> register_function(const std::string& name)
+    {
+        JSAutoRealm auto_realm { cx_.value_, current_scope_ };
+
+        constexpr auto functor = create_static_functor<F>();
+        JS::RootedObject scope { cx_.value_, current_scope_ };
+        if (JS_DefineFunction(cx_.value_, scope, name.data(), callback_for(functor), functor.num_args, 0) == nullptr) {
+            return engine_failure(cx_.value_, "Spidermonkey failed to define function");
+        }
+
         return {};
     }
 
     template <typename T>
     result<T> get_global(const std::string& name)
     {
+        static_assert(owning_result<T>, "Globals can't be read as views, read std::string or std::vector instead");
+
         JSAutoRealm auto_realm { cx_.value_, current_scope_ };
 
         JS::RootedValue prop { cx_.value_ };
@@ -148,7 +560,30 @@ public:
             return from_js<T>(cx_.value_, prop);
         }
 
-        return unexpected(std::format("No global property with the name {} was found", name));
+        return unexpected(error::format(error_code::not_found, "No global property with the name {} was found", name));
+    }
+
+    // converts a global into an existing value, which lets a map global be read back into the same
+    // container repeatedly without reallocating it
+    template <typename T>
+    result<void> get_global_into(const std::string& name, T& out)
+    {
+        static_assert(owning_result<T>, "Globals can't be read as views, read std::string or std::vector instead");
+
+        JSAutoRealm auto_realm { cx_.value_, current_scope_ };
+
+        JS::RootedValue prop { cx_.value_ };
+        bool prop_found { false };
+        JS::RootedObject scope { cx_.value_, current_scope_ };
+        if (JS_HasProperty(cx_.value_, scope, name.data(), &prop_found) && prop_found && JS_GetProperty(cx_.value_, scope, name.data(), &prop)) {
+            if constexpr (requires { converter<T>::from_js_into(cx_.value_, prop, out); }) {
+                return converter<T>::from_js_into(cx_.value_, prop, out);
+            } else {
+                return from_js<T>(cx_.value_, prop).transform([&](auto value) { out = std::move(value); });
+            }
+        }
+
+        return unexpected(error::format(error_code::not_found, "No global property with the name {} was found", name));
     }
 
     template <typename T>
@@ -160,7 +595,7 @@ public:
             JS::RootedValue value_handle { cx_.value_, v };
             JS::RootedObject scope { cx_.value_, current_scope_ };
             if (!JS_SetProperty(cx_.value_, scope, name.data(), value_handle)) {
-                return unexpected(std::format("Spidermonkey failed to set {} global", name));
+                return engine_failure(cx_.value_, "Spidermonkey failed to set {} global", name);
             }
             return {};
         });
@@ -171,48 +606,130 @@ public:
     {
         JSAutoRealm auto_realm { cx_.value_, current_scope_ };
 
-        return many_to_js(cx_.value_, std::forward<Args>(args)...).and_then([&](auto actual_args) -> result<ReturnType> {
-            JS::RootedValue call_return { cx_.value_ };
+        JS::RootedObject scope { cx_.value_, current_scope_ };
+        return call_with_args<ReturnType>(
+            cx_.value_,
+            [&](const JS::HandleValueArray& call_args, JS::MutableHandleValue call_return) -> result<void> {
+                if (!JS_CallFunctionName(cx_.value_, scope, name.data(), call_args, call_return)) {
+                    return engine_failure(cx_.value_, "Spidermonkey failed to call function with name {}", name);
+                }
+                return {};
+            },
+            std::forward<Args>(args)...);
+    }
+
+    template <typename ReturnType, typename... Args>
+    result<ReturnType> call_function(deadline until, const std::string& name, Args&&... args)
+    {
+        return with_deadline(until, [&]() { return call_function<ReturnType>(name, std::forward<Args>(args)...); });
+    }
+
+    // calls the function once per element of inputs, writing each call's result to the same index of out.
+    // The function is looked up and the realm entered once for the whole batch, and the rooted argument array
+    // and return value are reused by every call. Stops at the first call that fails
+    template <typename ReturnType, typename... Args>
+    result<void> call_function_batch(const std::string& name, std::span<const std::tuple<Args...>> inputs, std::span<ReturnType> out)
+    {
+        static_assert(owning_result<ReturnType>, "Script calls can't return views, return std::string or std::vector instead");
+
+        if (out.size() < inputs.size()) {
+            return unexpected(error { error_code::invalid_arguments, "Batch output is smaller than its input" });
+        }
+
+        JSAutoRealm auto_realm { cx_.value_, current_scope_ };
+
+        JS::RootedObject scope { cx_.value_, current_scope_ };
+        JS::RootedValue function { cx_.value_ };
+        if (!JS_GetProperty(cx_.value_, scope, name.data(), &function) || !function.isObject() || !JS_ObjectIsFunction(&function.toObject())) {
+            return unexpected(error::format(error_code::not_found, "No function with the name {} was found", name));
+        }
 
-            JS::RootedValueArray<sizeof...(args)> rooted_args {
-                cx_.value_,
-                std::apply(
-                    [&](auto&&... unwrapped_args) {
-                        return JS::ValueArray<sizeof...(unwrapped_args)> {
-                            std::forward<decltype(unwrapped_args)>(unwrapped_args)...
-                        };
-                    },
-                    std::move(actual_args))
-            };
-            JS::HandleValueArray call_args { rooted_args };
-            JS::RootedObject scope { cx_.value_, current_scope_ };
-            if (!JS_CallFunctionName(cx_.value_, scope, name.data(), call_args, &call_return)) {
-                return unexpected(std::format("Spidermonkey failed to call function with name {}", name));
-            }
+        JS::RootedValueArray<sizeof...(Args)> call_args { cx_.value_ };
+        JS::RootedValue call_return { cx_.value_ };
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            auto outcome = tuple_to_js(cx_.value_, inputs[i], call_args).and_then([&]() -> result<void> {
+                if (!JS_CallFunctionValue(cx_.value_, scope, function, call_args, &call_return)) {
+                    return engine_failure(cx_.value_, "Spidermonkey failed to call function with name {}", name);
+                }
 
-            if constexpr (!std::same_as<ReturnType, void>) {
-                return from_js<ReturnType>(cx_.value_, call_return);
-            } else {
-                return {};
+                return from_js<ReturnType>(cx_.value_, call_return).transform([&](auto value) { out[i] = std::move(value); });
+            });
+
+            if (!outcome.has_value()) {
+                return unexpected(error::format(outcome.error().code(), "Batch call {} failed: {}", i, outcome.error()));
             }
-        });
+        }
+
+        return {};
     }
 
+    template <typename Signature>
+    class function_handle;
+
+    // a script function resolved once by name, which can then be called repeatedly without looking it
+    // up again. The handle must not outlive the backend that created it
+    template <typename ReturnType, typename... ArgTypes>
+    class function_handle<ReturnType(ArgTypes...)> {
+    public:
+        function_handle(JSContext* cx, JSObject* scope, JSObject* function)
+            : cx_(cx)
+            , scope_(cx, scope)
+            , function_(cx, function)
+        {
+        }
+
+        result<ReturnType> call(ArgTypes... args)
+        {
+            JSAutoRealm auto_realm { cx_, function_ };
+
+            JS::RootedFunction function { cx_, JS_GetObjectFunction(function_) };
+            return call_with_args<ReturnType>(
+                cx_,
+                [&](const JS::HandleValueArray& call_args, JS::MutableHandleValue call_return) -> result<void> {
+                    if (!JS_CallFunction(cx_, scope_, function, call_args, call_return)) {
+                        return engine_failure(cx_, "Spidermonkey failed to call function handle");
+                    }
+                    return {};
+                },
+                static_cast<ArgTypes&&>(args)...);
+        }
+
+    private:
+        JSContext* cx_;
+        JS::PersistentRootedObject scope_;
+        JS::PersistentRootedObject function_;
+    };
+
+    template <typename Signature>
+    result<function_handle<Signature>> get_function(const std::string& name)
+    {
+        JSAutoRealm auto_realm { cx_.value_, current_scope_ };
+
+        JS::RootedObject scope { cx_.value_, current_scope_ };
+        JS::RootedValue function { cx_.value_ };
+        if (!JS_GetProperty(cx_.value_, scope, name.data(), &function) || !function.isObject() || !JS_ObjectIsFunction(&function.toObject())) {
+            return unexpected(error::format(error_code::not_found, "No function with the name {} was found", name));
+        }
+
+        return function_handle<Signature> { cx_.value_, scope, &function.toObject() };
+    }
+
+    // classes are registered per sandbox, objects of a class can only be passed to scripts in a sandbox
+    // the class was registered in
     template <registered_class T>
-    void register_class()
+    result<void> register_class()
     {
         JSAutoRealm auto_realm { cx_.value_, current_scope_ };
 
         JS::RootedObject scope { cx_.value_, current_scope_ };
-        class_registration_impl<T>::do_registration(cx_.value_, scope);
-        class_deregistrations_.push_back(class_registration_impl<T>::do_deregistration);
+        return class_registration_impl<T>::do_registration(cx_.value_, scope);
     }
 
     ~backend()
     {
-        for (auto dereg : class_deregistrations_) {
-            dereg();
-        }
+        JS_RemoveWeakPointerZonesCallback(cx_.value_, &context_data::sweep_wrappers);
+        JS::SetGCSliceCallback(cx_.value_, nullptr);
+        JS::SetOutOfMemoryCallback(cx_.value_, nullptr, nullptr);
     }
 
 private:
@@ -277,53 +794,504 @@ private:
         JSContext* value_;
     };
 
+    // JS_Init runs once per process, performed by whichever backend is created first on any thread. Each
+    // backend owns its own context, which must then only be used from the thread that created it
     static result<void> do_global_init()
     {
-        static bool result { JS_Init() };
+        static bool result = []() {
+            if (!JS_Init()) {
+                return false;
+            }
+
+            // XDR encoding and decoding, of cached scripts and of the shared self-hosted code, both need it
+            JS::SetProcessBuildIdOp(&engine_build_id_op);
+            return true;
+        }();
         static global_init init { result };
         if (!result) {
-            return unexpected("Spidermonkey failed to init (JS_Init)");
+            return unexpected(error { error_code::engine_failure, "Spidermonkey failed to init (JS_Init)" });
         }
 
         return {};
     }
 
-    static result<context> create_context()
+    static result<context> create_context(const backend_options& options)
     {
-        JSContext* value = JS_NewContext(JS::DefaultHeapMaxBytes);
+        JSContext* value = JS_NewContext(options.max_heap_bytes != 0 ? options.max_heap_bytes : JS::DefaultHeapMaxBytes);
         if (value) {
-            if (!JS::InitSelfHostedCode(value)) {
-                return unexpected("Spidermonkey error initializing self hosted code");
+            // owned from here, so the context is destroyed on any failure below
+            context cx { value };
+
+            if (options.max_nursery_bytes != 0) {
+                JS_SetGCParameter(value, JSGC_MAX_NURSERY_BYTES, options.max_nursery_bytes);
+            }
+            JS_SetGCParameter(value, JSGC_INCREMENTAL_GC_ENABLED, options.incremental_gc);
+            if (options.gc_slice_budget.count() != 0) {
+                JS_SetGCParameter(value, JSGC_SLICE_TIME_BUDGET_MS, static_cast<uint32_t>(options.gc_slice_budget.count()));
+            }
+            auto set_jit_option = [&](JSJitCompilerOption option, auto setting) {
+                if (setting.has_value()) {
+                    JS_SetGlobalJitCompilerOption(value, option, static_cast<uint32_t>(*setting));
+                }
+            };
+            set_jit_option(JSJITCOMPILER_BASELINE_INTERPRETER_ENABLE, options.baseline_interpreter_enabled);
+            set_jit_option(JSJITCOMPILER_BASELINE_INTERPRETER_WARMUP_TRIGGER, options.baseline_interpreter_warmup);
+            set_jit_option(JSJITCOMPILER_BASELINE_ENABLE, options.baseline_jit_enabled);
+            set_jit_option(JSJITCOMPILER_BASELINE_WARMUP_TRIGGER, options.baseline_jit_warmup);
+            set_jit_option(JSJITCOMPILER_ION_ENABLE, options.ion_enabled);
+            set_jit_option(JSJITCOMPILER_ION_NORMAL_WARMUP_TRIGGER, options.ion_warmup);
+
+#ifdef JS_GC_ZEAL
+            if (!options.allow_gc_zeal) {
+                JS_SetGCZeal(value, 0, 0);
+            }
+#endif
+
+            // spidermonkey's own job queue, without which promises never settle
+            if (!js::UseInternalJobQueues(value)) {
+                return unexpected(error { error_code::engine_failure, "Spidermonkey failed to create its job queue" });
+            }
+
+            if (!init_self_hosted_code(value)) {
+                return unexpected(error { error_code::engine_failure, "Spidermonkey error initializing self hosted code" });
             }
-            return context { value };
+            return cx;
         } else {
-            return unexpected("Spidermonkey failed to create context (JS_NewContext)");
+            return unexpected(error { error_code::engine_failure, "Spidermonkey failed to create context (JS_NewContext)" });
+        }
+    }
+
+    // spidermonkey's builtins are partly written in JS, which every context has to load. The first context
+    // in the process compiles them and encodes the result, every later one decodes that instead
+    static bool init_self_hosted_code(JSContext* cx)
+    {
+        struct self_hosted_cache {
+            std::mutex mutex_;
+            std::vector<uint8_t> data_;
+            bool written_ { false };
+        };
+
+        // never destroyed, spidermonkey may refer to the data for as long as any context exists
+        static auto* cache = new self_hosted_cache;
+
+        std::unique_lock lock { cache->mutex_ };
+        if (cache->written_) {
+            lock.unlock();
+            return JS::InitSelfHostedCode(cx, JS::SelfHostedCache { cache->data_.data(), cache->data_.size() });
         }
+
+        // held while compiling, so contexts created concurrently with the first wait for its cache rather
+        // than all compiling their own
+        return JS::InitSelfHostedCode(cx, JS::SelfHostedCache {}, [](JSContext*, JS::SelfHostedCache data) {
+            cache->data_.assign(data.begin(), data.end());
+            cache->written_ = true;
+            return true;
+        });
     }
 
-    static result<JSObject*> create_global_scope(JSContext* cx)
+    static result<JSObject*> create_global_scope(JSContext* cx, const JS::RealmOptions& options = {})
     {
         static JSClass global_object { "GlobalObject", JSCLASS_GLOBAL_FLAGS, &JS::DefaultGlobalClassOps, nullptr, nullptr, nullptr };
-        JS::RealmOptions options;
         JSObject* result = JS_NewGlobalObject(cx, &global_object, nullptr, JS::FireOnNewGlobalHook, options);
         if (result == nullptr) {
-            return unexpected("Spidermonkey error creating global scope");
+            return unexpected(error { error_code::engine_failure, "Spidermonkey error creating global scope" });
         }
 
         return result;
     }
 
+    result<void> compile_script(const std::string& code, JS::MutableHandleScript script)
+    {
+        JS::CompileOptions compile_options { cx_.value_ };
+        compile_options.setFileAndLine("inline", 1);
+
+        if (script_cache_) {
+            return compile_stencil(compile_options, code).and_then([&](auto stencil) {
+                return instantiate_stencil(stencil, script);
+            });
+        }
+
+        JS::SourceText<mozilla::Utf8Unit> source;
+        if (!source.init(cx_.value_, code.data(), code.size(), JS::SourceOwnership::Borrowed)) {
+            return unexpected(error { error_code::engine_failure, "Spidermonkey failed to init source\n" });
+        }
+
+        script.set(JS::Compile(cx_.value_, compile_options, source));
+        if (script == nullptr) {
+            return engine_failure(cx_.value_, "Spidermonkey failed to compile script\n");
+        }
+
+        return {};
+    }
+
+    result<RefPtr<JS::Stencil>> compile_stencil(const JS::ReadOnlyCompileOptions& compile_options, const std::string& code)
+    {
+        if (script_cache_) {
+            if (auto stencil = script_cache_->load(cx_.value_, compile_options, code)) {
+                return stencil;
+            }
+        }
+
+        JS::SourceText<mozilla::Utf8Unit> source;
+        if (!source.init(cx_.value_, code.data(), code.size(), JS::SourceOwnership::Borrowed)) {
+            return unexpected(error { error_code::engine_failure, "Spidermonkey failed to init source\n" });
+        }
+
+        RefPtr<JS::Stencil> stencil = JS::CompileGlobalScriptToStencil(cx_.value_, compile_options, source);
+        if (!stencil) {
+            return engine_failure(cx_.value_, "Spidermonkey failed to compile script\n");
+        }
+
+        if (script_cache_) {
+            script_cache_->store(cx_.value_, code, stencil);
+        }
+
+        return stencil;
+    }
+
+    result<void> instantiate_stencil(JS::Stencil* stencil, JS::MutableHandleScript script)
+    {
+        JS::CompileOptions compile_options { cx_.value_ };
+        compile_options.setFileAndLine("inline", 1);
+
+        JS::InstantiateOptions instantiate_options { compile_options };
+        script.set(JS::InstantiateGlobalStencil(cx_.value_, instantiate_options, stencil));
+        if (script == nullptr) {
+            return engine_failure(cx_.value_, "Spidermonkey failed to instantiate compiled script\n");
+        }
+
+        return {};
+    }
+
+    // runs call, interrupting the script it runs if it's still going once until passes
+    template <typename Call>
+    auto with_deadline(deadline until, Call&& call)
+    {
+        auto retval = [&]() {
+            auto guard = watchdog::get().watch(until, [cx = cx_.value_, data = context_data_.get()]() {
+                data->deadline_expired_ = true;
+                JS_RequestInterruptCallback(cx);
+            });
+            return call();
+        }();
+
+        // the guard is gone, so the flag can no longer change under us. An interrupt which was requested
+        // as the call returned stays pending, but is harmless now the flag is cleared
+        if (context_data_->deadline_expired_.exchange(false) && !retval.has_value()) {
+            retval = unexpected(error { error_code::deadline_exceeded, "Script call exceeded its deadline" });
+        }
+
+        return retval;
+    }
+
+    // converts each element of args into the slot of out at the same index
+    template <std::size_t I = 0, typename... Args, std::size_t N>
+    static result<void> tuple_to_js(JSContext* cx, const std::tuple<Args...>& args, JS::RootedValueArray<N>& out)
+    {
+        if constexpr (I == sizeof...(Args)) {
+            return {};
+        } else {
+            return to_js(cx, std::get<I>(args)).and_then([&](JS::Value v) -> result<void> {
+                out[I].set(v);
+                return tuple_to_js<I + 1>(cx, args, out);
+            });
+        }
+    }
+
+    // converts args, then calls invoke with them rooted and converts whatever it returned
+    template <typename ReturnType, typename Invoke, typename... Args>
+    static result<ReturnType> call_with_args(JSContext* cx, Invoke&& invoke, Args&&... args)
+    {
+        static_assert(owning_result<ReturnType>, "Script calls can't return views, return std::string or std::vector instead");
+
+        return many_to_js(cx, std::forward<Args>(args)...).and_then([&](auto actual_args) -> result<ReturnType> {
+            JS::RootedValue call_return { cx };
+
+            JS::RootedValueArray<sizeof...(args)> rooted_args {
+                cx,
+                std::apply(
+                    [&](auto&&... unwrapped_args) {
+                        return JS::ValueArray<sizeof...(unwrapped_args)> {
+                            std::forward<decltype(unwrapped_args)>(unwrapped_args)...
+                        };
+                    },
+                    std::move(actual_args))
+            };
+            JS::HandleValueArray call_args { rooted_args };
+
+            return invoke(call_args, &call_return).and_then([&]() -> result<ReturnType> {
+                if constexpr (!std::same_as<ReturnType, void>) {
+                    return from_js<ReturnType>(cx, call_return);
+                } else {
+                    return {};
+                }
+            });
+        });
+    }
+
+    template <typename ReturnType>
+    result<ReturnType> run_script(JS::HandleScript script)
+    {
+        static_assert(owning_result<ReturnType>, "Scripts can't return views, return std::string or std::vector instead");
+
+        JS::RootedValue return_value { cx_.value_ };
+        if (!JS_ExecuteScript(cx_.value_, script, &return_value)) {
+            return engine_failure(cx_.value_, "Spidermonkey failed to execute script\n");
+        }
+
+        if constexpr (!std::same_as<ReturnType, void>) {
+            return from_js<ReturnType>(cx_.value_, return_value);
+        } else {
+            return {};
+        }
+    }
+
     backend(context cx, JSObject* global_scope)
         : cx_(std::move(cx))
+        , context_data_(std::make_unique<context_data>())
         , global_scope_(cx_.value_, global_scope)
         , current_scope_(global_scope_.get())
     {
+        JS_SetContextPrivate(cx_.value_, context_data_.get());
+        js::SetDOMCallbacks(cx_.value_, &dom_callbacks);
+        JS_AddWeakPointerZonesCallback(cx_.value_, &context_data::sweep_wrappers, context_data_.get());
+        JS::SetGCSliceCallback(cx_.value_, &context_data::on_gc_slice);
+        JS::SetOutOfMemoryCallback(cx_.value_, &context_data::on_out_of_memory, context_data_.get());
+        JS_AddInterruptCallback(cx_.value_, &context_data::on_interrupt);
     }
 
     context cx_;
+    std::unique_ptr<context_data> context_data_;
     JS::RootedObject global_scope_;
     JSObject* current_scope_;
-    std::vector<void (*)()> class_deregistrations_;
+    std::optional<script_cache> script_cache_;
+    std::unique_ptr<profiler> profiler_;
+};
+
+// sandboxes which are prepared once (functors and classes registered, setup scripts run) and then reused.
+// When a lease ends, the sandbox's global properties are reset to the baseline recorded after setup, which
+// is far cheaper than creating and preparing a new sandbox for every request. Only global properties are
+// reset, changes to builtin objects (e.g. Array.prototype) survive. A sandbox that can't be reset is
+// discarded instead of reused: one given a new top level var or function, which are non-configurable, or
+// a new top level let/const/class, which can't be removed from the global lexical environment and would
+// make the same script fail with a redeclaration error next time. The pool must not outlive its backend,
+// and its leases must not outlive the pool
+class backend::sandbox_pool {
+    struct entry {
+        entry(sandbox&& s, JSContext* cx)
+            : sandbox_(std::move(s))
+            , baseline_(cx)
+        {
+        }
+
+        sandbox sandbox_;
+        JS::PersistentRootedObject baseline_;
+        std::size_t lexical_bindings_ { 0 };
+    };
+
+public:
+    // called with the new sandbox active, so registrations and scripts made through the backend or the
+    // glua::instance owning it apply to the sandbox
+    using setup_function = std::function<result<void>()>;
+
+    class lease {
+    public:
+        lease(sandbox_pool& pool, std::unique_ptr<entry> pooled)
+            : pool_(&pool)
+            , entry_(std::move(pooled))
+        {
+        }
+
+        lease(const lease&) = delete;
+        lease(lease&& move)
+            : pool_(std::exchange(move.pool_, nullptr))
+            , entry_(std::move(move.entry_))
+        {
+        }
+
+        ~lease()
+        {
+            if (pool_)
+                pool_->release(std::move(entry_));
+        }
+
+        sandbox* get() { return &entry_->sandbox_; }
+
+    private:
+        sandbox_pool* pool_;
+        std::unique_ptr<entry> entry_;
+    };
+
+    static result<std::unique_ptr<sandbox_pool>> create(backend& js, setup_function setup, sandbox_compartment compartment = sandbox_compartment::separate)
+    {
+        return std::unique_ptr<sandbox_pool> { new sandbox_pool { js, std::move(setup), compartment } };
+    }
+
+    // an idle sandbox if there is one, otherwise a newly prepared one
+    result<lease> acquire()
+    {
+        if (!idle_.empty()) {
+            auto pooled = std::move(idle_.back());
+            idle_.pop_back();
+            return lease { *this, std::move(pooled) };
+        }
+
+        return create_entry().transform([&](auto pooled) { return lease { *this, std::move(pooled) }; });
+    }
+
+    // prepares sandboxes ahead of time, so the first requests don't pay for creating them
+    result<void> reserve(std::size_t count)
+    {
+        while (idle_.size() < count) {
+            auto pooled = create_entry();
+            if (!pooled.has_value()) {
+                return unexpected(std::move(pooled).error());
+            }
+            idle_.push_back(std::move(pooled).value());
+        }
+
+        return {};
+    }
+
+    std::size_t idle() const { return idle_.size(); }
+
+private:
+    sandbox_pool(backend& js, setup_function setup, sandbox_compartment compartment)
+        : js_(js)
+        , setup_(std::move(setup))
+        , compartment_(compartment)
+    {
+    }
+
+    static constexpr unsigned all_own_keys = JSITER_OWNONLY | JSITER_HIDDEN | JSITER_SYMBOLS;
+
+    // defines every own property of from on to, as is
+    static bool copy_own_properties(JSContext* cx, JS::HandleObject from, JS::HandleObject to)
+    {
+        JS::RootedIdVector ids { cx };
+        if (!js::GetPropertyKeys(cx, from, all_own_keys, &ids)) {
+            return false;
+        }
+
+        JS::Rooted<mozilla::Maybe<JS::PropertyDescriptor>> found { cx };
+        JS::Rooted<JS::PropertyDescriptor> descriptor { cx };
+        for (std::size_t i = 0; i < ids.length(); ++i) {
+            if (!JS_GetOwnPropertyDescriptorById(cx, from, ids[i], &found)) {
+                return false;
+            }
+            if (found.get().isNothing()) {
+                continue;
+            }
+
+            descriptor = *found.get();
+            if (!JS_DefinePropertyById(cx, to, ids[i], descriptor)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // top level let/const/class bindings live in the global's lexical environment rather than on the global.
+    // Bindings are never removed from it, so a changed count means new ones were declared
+    static bool count_lexical_bindings(JSContext* cx, JS::HandleObject global, std::size_t& count)
+    {
+        JS::RootedObject lexical { cx, JS_GlobalLexicalEnvironment(global) };
+        JS::RootedIdVector ids { cx };
+        if (!lexical || !js::GetPropertyKeys(cx, lexical, all_own_keys, &ids)) {
+            return false;
+        }
+
+        count = ids.length();
+        return true;
+    }
+
+    result<std::unique_ptr<entry>> create_entry()
+    {
+        JSContext* cx = js_.cx_.value_;
+
+        return js_.create_sandbox(compartment_).and_then([&](auto created) -> result<std::unique_ptr<entry>> {
+            auto pooled = std::make_unique<entry>(std::move(created), cx);
+            JS::RootedObject global { cx, pooled->sandbox_.scope_ };
+
+            JSAutoRealm auto_realm { cx, global };
+
+            // builtins are otherwise defined the first time they're used, which would make them look like
+            // properties added by a request and have them deleted on reset
+            if (!JS::InitRealmStandardClasses(cx)) {
+                return engine_failure(cx, "Spidermonkey failed to initialize sandbox builtins");
+            }
+
+            auto* previous_scope = js_.current_scope_;
+            js_.current_scope_ = global;
+            auto prepared = setup_();
+            js_.current_scope_ = previous_scope;
+            if (!prepared.has_value()) {
+                return unexpected(std::move(prepared).error());
+            }
+
+            JS::RootedObject baseline { cx, JS_NewObjectWithGivenProto(cx, nullptr, nullptr) };
+            if (!baseline || !copy_own_properties(cx, global, baseline) || !count_lexical_bindings(cx, global, pooled->lexical_bindings_)) {
+                return engine_failure(cx, "Spidermonkey failed to record the sandbox baseline");
+            }
+            pooled->baseline_ = baseline;
+
+            return pooled;
+        });
+    }
+
+    // deletes the properties added since the baseline and restores the rest to their baseline values
+    bool reset(entry& pooled)
+    {
+        JSContext* cx = js_.cx_.value_;
+        JS::RootedObject global { cx, pooled.sandbox_.scope_ };
+        JS::RootedObject baseline { cx, pooled.baseline_ };
+
+        JSAutoRealm auto_realm { cx, global };
+
+        std::size_t lexical_bindings { 0 };
+        if (!count_lexical_bindings(cx, global, lexical_bindings) || lexical_bindings != pooled.lexical_bindings_) {
+            return false;
+        }
+
+        JS::RootedIdVector ids { cx };
+        if (!js::GetPropertyKeys(cx, global, all_own_keys, &ids)) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < ids.length(); ++i) {
+            bool in_baseline { false };
+            if (!JS_HasOwnPropertyById(cx, baseline, ids[i], &in_baseline)) {
+                return false;
+            }
+
+            JS::ObjectOpResult deleted;
+            if (!in_baseline && (!JS_DeletePropertyById(cx, global, ids[i], deleted) || !deleted.ok())) {
+                return false;
+            }
+        }
+
+        // redefining an unchanged property is a no-op, so everything is simply redefined
+        return copy_own_properties(cx, baseline, global);
+    }
+
+    void release(std::unique_ptr<entry> pooled)
+    {
+        if (js_.current_scope_ == pooled->sandbox_.scope_.get()) {
+            js_.set_active_sandbox(nullptr);
+        }
+
+        if (reset(*pooled)) {
+            idle_.push_back(std::move(pooled));
+        } else {
+            JS_ClearPendingException(js_.cx_.value_);
+        }
+    }
+
+    backend& js_;
+    setup_function setup_;
+    sandbox_compartment compartment_;
+    std::vector<std::unique_ptr<entry>> idle_;
 };
 
 } // namespace spidermonkey
@@ -4,21 +4,28 @@
 // crafted to separate declarations and dependent definitions
 
 namespace glua::spidermonkey {
+// a wrapper stores its object pointer and flags directly in reserved slots, so wrapping needs no allocation
+// beyond the JS object itself. The shared ownership record is only created once the wrapper is converted
+// into a glua::any, which may outlive the wrapper
 constexpr std::size_t SLOT_OBJECT_PTR { 0 };
-constexpr std::size_t SLOT_COUNT { 1 };
+constexpr std::size_t SLOT_FLAGS { 1 };
+constexpr std::size_t SLOT_SHARED_DATA { 2 };
+constexpr std::size_t SLOT_COUNT { 3 };
+
+constexpr int32_t FLAG_MUTABLE { 1 << 0 };
+constexpr int32_t FLAG_OWNED_BY_JS { 1 << 1 };
 
 struct class_registration_data;
 using class_registration_data_ptr = std::shared_ptr<class_registration_data>;
 
 using registered_class_finalizer = void (*)(void*);
-using to_any = std::unique_ptr<any_impl> (*)(class_registration_data_ptr*);
+using to_any = std::unique_ptr<any_impl> (*)(JSObject*);
 
 struct class_registration_data {
-    class_registration_data(void* ptr, bool owned_by_js, bool is_mutable, to_any make_any, registered_class_finalizer f)
+    class_registration_data(void* ptr, bool owned_by_js, bool is_mutable, registered_class_finalizer f)
         : ptr_(ptr)
         , owned_by_js_(owned_by_js)
         , mutable_(is_mutable)
-        , make_any_(make_any)
         , finalizer_(f)
     {
     }
@@ -33,15 +40,85 @@ struct class_registration_data {
     void* ptr_;
     bool owned_by_js_;
     bool mutable_;
-    to_any make_any_;
     registered_class_finalizer finalizer_;
 };
 
+// every registered class points at this extension, which is how a wrapper is recognized without knowing its T
+inline constexpr JSClassExtension registered_class_extension {};
+
+struct registered_class_info {
+    JSClass class_; // must remain the first member, spidermonkey is only ever given a pointer to it
+    to_any make_any_;
+    uint16_t (*jit_proto_id_)(); // nullptr unless the class opted into jit_info
+};
+
+inline const registered_class_info* get_registered_class_info(JSObject* obj)
+{
+    const JSClass* c = JS::GetClass(obj);
+    if (c->ext != &registered_class_extension)
+        return nullptr;
+
+    return reinterpret_cast<const registered_class_info*>(c);
+}
+
+// a class opts into JIT-visible bindings by declaring `static constexpr bool jit_info = true;` in its
+// class_registration. Methods and field getters then carry JSJitInfo the way DOM bindings do, which
+// lets the JIT call them directly instead of through a generic native call
+template <typename T>
+concept jit_info_class = requires {
+    {
+        class_registration<T>::jit_info
+    } -> std::convertible_to<bool>;
+} && class_registration<T>::jit_info;
+
+inline uint16_t next_jit_proto_id()
+{
+    static std::atomic<uint16_t> counter { 0 };
+    return counter++;
+}
+
+// the JIT asks this whether an object's class matches the class a JSJitInfo was created for, registered
+// classes have no inheritance so only depth 0 can ever match
+inline bool instance_class_matches_proto(const JSClass* instance_class, uint32_t proto_id, uint32_t depth)
+{
+    if (instance_class->ext != &registered_class_extension)
+        return false;
+
+    const auto* info = reinterpret_cast<const registered_class_info*>(instance_class);
+    return depth == 0 && info->jit_proto_id_ != nullptr && info->jit_proto_id_() == proto_id;
+}
+
+inline constexpr js::DOMCallbacks dom_callbacks { instance_class_matches_proto };
+
+template <typename V>
+constexpr JSValueType jit_value_type()
+{
+    // only types whose converters always produce exactly this JS::Value type may be reported, the JIT
+    // trusts it without checking
+    using D = std::decay_t<V>;
+    if constexpr (std::same_as<D, bool>)
+        return JSVAL_TYPE_BOOLEAN;
+    else if constexpr (std::same_as<D, int8_t> || std::same_as<D, uint8_t> || std::same_as<D, int16_t> || std::same_as<D, uint16_t> || std::same_as<D, int32_t>)
+        return JSVAL_TYPE_INT32;
+    else if constexpr (std::same_as<D, float> || std::same_as<D, double>)
+        return JSVAL_TYPE_DOUBLE;
+    else if constexpr (std::same_as<D, std::string>)
+        return JSVAL_TYPE_STRING;
+    else
+        return JSVAL_TYPE_UNKNOWN;
+}
+
 template <registered_class T>
 struct class_registration_impl {
     using registration = class_registration<T>;
 
-    static std::unique_ptr<any_impl> make_any(class_registration_data_ptr* obj)
+    using methods_tuple = decltype(registration::methods);
+    static constexpr std::size_t num_methods = std::tuple_size_v<methods_tuple>;
+
+    using fields_tuple = decltype(registration::fields);
+    static constexpr std::size_t num_fields = std::tuple_size_v<fields_tuple>;
+
+    static std::unique_ptr<any_impl> make_any(JSObject* obj)
     {
         struct any_registered_class_impl : any_spidermonkey_impl {
             any_registered_class_impl(class_registration_data_ptr value)
@@ -51,35 +128,61 @@ struct class_registration_impl {
 
             result<JS::Value> to_js(JSContext* cx) const override
             {
-                JS::RootedObject obj { cx, JS_NewObjectWithGivenProto(cx, &class_, proto_) };
+                const int32_t flags = value_->mutable_ ? FLAG_MUTABLE : 0;
 
                 // new shared_ptr*, copying existing shared_ptr
-                auto* wrapper_ptr = new class_registration_data_ptr { value_ };
-
-                JS::SetReservedSlot(obj, SLOT_OBJECT_PTR, JS::PrivateValue(wrapper_ptr));
-
-                return JS::ObjectValue(*obj);
+                return create_wrapper(cx, value_->ptr_, flags, new class_registration_data_ptr { value_ })
+                    .transform([](auto* obj) { return JS::ObjectValue(*obj); });
             }
 
             class_registration_data_ptr value_;
         };
 
-        return std::make_unique<any_registered_class_impl>(*obj); // copy shared ownership here
+        return std::make_unique<any_registered_class_impl>(shared_data(obj));
+    }
+
+    static class_registration_data_ptr shared_data(JSObject* obj)
+    {
+        const JS::Value& shared_value = JS::GetReservedSlot(obj, SLOT_SHARED_DATA);
+        if (!shared_value.isUndefined()) {
+            return *static_cast<class_registration_data_ptr*>(shared_value.toPrivate());
+        }
+
+        // first conversion into an any, ownership moves into a shared record held by both the wrapper and the any
+        const int32_t flags = JS::GetReservedSlot(obj, SLOT_FLAGS).toInt32();
+        auto* shared_ptr = new class_registration_data_ptr {
+            std::make_shared<class_registration_data>(
+                JS::GetReservedSlot(obj, SLOT_OBJECT_PTR).toPrivate(),
+                (flags & FLAG_OWNED_BY_JS) != 0,
+                (flags & FLAG_MUTABLE) != 0,
+                finalizer_vp)
+        };
+
+        JS::SetReservedSlot(obj, SLOT_FLAGS, JS::Int32Value(flags & ~FLAG_OWNED_BY_JS));
+        JS::SetReservedSlot(obj, SLOT_SHARED_DATA, JS::PrivateValue(shared_ptr));
+
+        return *shared_ptr;
     }
 
     static result<T*> unwrap_object(JSContext*, JS::HandleValue v)
     {
         if (v.isObject()) {
             JSObject& obj = v.toObject();
-            const JS::Value& reserved_value = JS::GetReservedSlot(&obj, SLOT_OBJECT_PTR);
-            auto* data = reinterpret_cast<class_registration_data_ptr*>(reserved_value.toPrivate())->get();
+            if (JS::GetClass(&obj) != &info_.class_) {
+                return unexpected(error { error_code::conversion_failed, "unwrap failed - object is not of the expected registered class" });
+            }
 
-            if (data->mutable_)
-                return reinterpret_cast<T*>(data->ptr_);
+            const JS::Value& flags = JS::GetReservedSlot(&obj, SLOT_FLAGS);
+            if (!flags.isInt32()) {
+                return unexpected(error { error_code::conversion_failed, "unwrap failed - object is a class prototype" });
+            }
+
+            if (flags.toInt32() & FLAG_MUTABLE)
+                return static_cast<T*>(JS::GetReservedSlot(&obj, SLOT_OBJECT_PTR).toPrivate());
             else
-                return unexpected("unwrap failed - attempted to extract mutable reference to const object");
+                return unexpected(error { error_code::conversion_failed, "unwrap failed - attempted to extract mutable reference to const object" });
         } else {
-            return unexpected("unwrap on non-object value");
+            return unexpected(error { error_code::conversion_failed, "unwrap on non-object value" });
         }
     }
 
@@ -87,25 +190,65 @@ struct class_registration_impl {
     {
         if (v.isObject()) {
             JSObject& obj = v.toObject();
-            const JS::Value& reserved_value = JS::GetReservedSlot(&obj, SLOT_OBJECT_PTR);
-            auto* data = reinterpret_cast<class_registration_data_ptr*>(reserved_value.toPrivate())->get();
-            return reinterpret_cast<T*>(data->ptr_);
+            if (JS::GetClass(&obj) != &info_.class_) {
+                return unexpected(error { error_code::conversion_failed, "unwrap (const) failed - object is not of the expected registered class" });
+            }
+
+            const JS::Value& ptr = JS::GetReservedSlot(&obj, SLOT_OBJECT_PTR);
+            if (ptr.isUndefined()) {
+                return unexpected(error { error_code::conversion_failed, "unwrap (const) failed - object is a class prototype" });
+            }
+
+            return static_cast<const T*>(ptr.toPrivate());
         } else {
-            return unexpected("unwrap (const) on non-object value");
+            return unexpected(error { error_code::conversion_failed, "unwrap (const) on non-object value" });
         }
     }
 
-    static result<JSObject*> wrap_object(JSContext* cx, T* obj_ptr, bool owned_by_js = false)
+    static result<JSObject*> create_wrapper(JSContext* cx, void* obj_ptr, int32_t flags, class_registration_data_ptr* shared_ptr = nullptr)
     {
-        JS::RootedObject obj { cx, JS_NewObjectWithGivenProto(cx, &class_, proto_) };
+        JS::RootedObject proto { cx, get_context_data(cx).find_proto(JS::GetCurrentRealmOrNull(cx), &info_.class_) };
+        if (proto == nullptr) {
+            delete shared_ptr;
+            return unexpected(error::format(error_code::conversion_failed, "Could not wrap object, class {} is not registered in the current sandbox", registration::name));
+        }
 
-        auto* wrapper_ptr = new class_registration_data_ptr {
-            std::make_shared<class_registration_data>(obj_ptr, owned_by_js, true, make_any, finalizer_vp)
-        };
+        JS::RootedObject obj { cx, JS_NewObjectWithGivenProto(cx, &info_.class_, proto) };
+        if (obj == nullptr) {
+            delete shared_ptr;
+            return unexpected(error { error_code::engine_failure, "Spidermonkey failed to create wrapper object" });
+        }
 
-        JS::SetReservedSlot(obj, SLOT_OBJECT_PTR, JS::PrivateValue(wrapper_ptr));
+        JS::SetReservedSlot(obj, SLOT_OBJECT_PTR, JS::PrivateValue(obj_ptr));
+        JS::SetReservedSlot(obj, SLOT_FLAGS, JS::Int32Value(flags));
+        if (shared_ptr != nullptr)
+            JS::SetReservedSlot(obj, SLOT_SHARED_DATA, JS::PrivateValue(shared_ptr));
 
-        return obj;
+        return obj.get();
+    }
+
+    // wrappers are reused while alive, per realm and constness, so returning the same object twice yields the
+    // same JS object. A wrapper that takes ownership is always new, and replaces any existing borrowed wrapper
+    // so later references resolve to the owner
+    static result<JSObject*> wrap_cached(JSContext* cx, void* obj_ptr, int32_t flags)
+    {
+        auto& wrappers = get_context_data(cx).wrappers_;
+        context_data::wrapper_key key { JS::GetCurrentRealmOrNull(cx), &info_.class_, obj_ptr, (flags & FLAG_MUTABLE) != 0 };
+
+        if (!(flags & FLAG_OWNED_BY_JS)) {
+            if (auto pos = wrappers.find(key); pos != wrappers.end())
+                return pos->second.get();
+        }
+
+        return create_wrapper(cx, obj_ptr, flags).transform([&](JSObject* obj) {
+            wrappers.insert_or_assign(key, obj);
+            return obj;
+        });
+    }
+
+    static result<JSObject*> wrap_object(JSContext* cx, T* obj_ptr, bool owned_by_js = false)
+    {
+        return wrap_cached(cx, obj_ptr, FLAG_MUTABLE | (owned_by_js ? FLAG_OWNED_BY_JS : 0));
     }
 
     static result<JSObject*> wrap_object(JSContext* cx, std::unique_ptr<T> obj_ptr)
@@ -120,17 +263,9 @@ struct class_registration_impl {
 
     static result<JSObject*> wrap_object(JSContext* cx, const T* obj_ptr, bool owned_by_js = false)
     {
-        JS::RootedObject obj { cx, JS_NewObjectWithGivenProto(cx, &class_, proto_) };
-
         // const_cast here is obviously a const violation, it means at runtime we're now responsible
         // for const checking
-        auto* wrapper_ptr = new class_registration_data_ptr {
-            std::make_shared<class_registration_data>(const_cast<T*>(obj_ptr), owned_by_js, false, make_any, finalizer_vp)
-        };
-
-        JS::SetReservedSlot(obj, SLOT_OBJECT_PTR, JS::PrivateValue(wrapper_ptr));
-
-        return obj;
+        return wrap_cached(cx, const_cast<T*>(obj_ptr), owned_by_js ? FLAG_OWNED_BY_JS : 0);
     }
 
     static bool constructor(JSContext* cx, unsigned argc, JS::Value* vp)
@@ -141,13 +276,18 @@ struct class_registration_impl {
 
     static void finalizer(JS::GCContext*, JSObject* obj)
     {
-        const JS::Value& reserved_value = JS::GetReservedSlot(obj, SLOT_OBJECT_PTR);
-        auto* data = reinterpret_cast<class_registration_data_ptr*>(reserved_value.toPrivate());
+        const JS::Value& shared_value = JS::GetReservedSlot(obj, SLOT_SHARED_DATA);
+        if (!shared_value.isUndefined()) {
+            // this deletes the shared_ptr<class_registration_data>, which may or may not delete
+            // the actual T* within, depending on owned_by_js_ value
+            delete static_cast<class_registration_data_ptr*>(shared_value.toPrivate());
+            return;
+        }
 
-        // this deletes the shared_ptr<class_registration_data>, which may or may not delete
-        // the actual T* within, depending on owned_by_js_ value
-        // NOTE: data may be nullptr (in the case of the proto_ object)
-        delete data;
+        // NOTE: the slots are never set on a prototype object, so it is never treated as owned
+        const JS::Value& flags = JS::GetReservedSlot(obj, SLOT_FLAGS);
+        if (flags.isInt32() && (flags.toInt32() & FLAG_OWNED_BY_JS))
+            finalizer_vp(JS::GetReservedSlot(obj, SLOT_OBJECT_PTR).toPrivate());
     }
 
     static void finalizer_vp(void* data_ptr)
@@ -160,29 +300,53 @@ struct class_registration_impl {
     {
         auto args = JS::CallArgsFromVp(argc, vp);
         auto& method_data = std::get<MethodIndex>(registration::methods);
+        profiler_label label { cx, method_data.name_.data(), registration::name.data() };
 
-        return call_generic_wrapped_method(*method_data.generic_functor_ptr_, cx, args);
+        return call_generic_wrapped_method(*method_data.generic_functor_ptr_, cx, args.thisv(), args);
+    }
+
+    template <std::size_t MethodIndex>
+    static bool jit_method_call(JSContext* cx, JS::HandleObject obj, void*, const JSJitMethodCallArgs& args)
+    {
+        JS::RootedValue thisv { cx, JS::ObjectValue(*obj) };
+        auto& method_data = std::get<MethodIndex>(registration::methods);
+        profiler_label label { cx, method_data.name_.data(), registration::name.data() };
+
+        return call_generic_wrapped_method(*method_data.generic_functor_ptr_, cx, thisv, args);
     }
 
     template <std::size_t FieldIndex>
-    static bool field_getter(JSContext* cx, unsigned argc, JS::Value* vp)
+    static bool get_field(JSContext* cx, JS::HandleValue thisv, JS::MutableHandleValue rval)
     {
-        auto args = JS::CallArgsFromVp(argc, vp);
         auto& field_data = std::get<FieldIndex>(registration::fields);
 
         return [&]<typename FieldType>(FieldType T::*field_ptr) {
-            return from_js<const T&>(cx, args.thisv()).and_then([&](const T& obj) {
-                return to_js(cx, obj.*field_ptr).transform([&](auto value) { args.rval().set(value); });
+            return from_js<const T&>(cx, thisv).and_then([&](const T& obj) {
+                return to_js(cx, obj.*field_ptr).transform([&](auto value) { rval.set(value); });
             });
         }(field_data.field_ptr_)
                    .transform([]() { return true; })
                    .or_else([&](const auto& error) -> result<bool> {
-                       JS_ReportErrorASCII(cx, "%s", error.data());
+                       JS_ReportErrorASCII(cx, "%s", error.c_str());
                        return false;
                    })
                    .value();
     }
 
+    template <std::size_t FieldIndex>
+    static bool field_getter(JSContext* cx, unsigned argc, JS::Value* vp)
+    {
+        auto args = JS::CallArgsFromVp(argc, vp);
+        return get_field<FieldIndex>(cx, args.thisv(), args.rval());
+    }
+
+    template <std::size_t FieldIndex>
+    static bool jit_field_getter(JSContext* cx, JS::HandleObject obj, void*, JSJitGetterCallArgs args)
+    {
+        JS::RootedValue thisv { cx, JS::ObjectValue(*obj) };
+        return get_field<FieldIndex>(cx, thisv, args.rval());
+    }
+
     static bool illegal_field_setter(JSContext* cx, unsigned, JS::Value*)
     {
         JS_ReportErrorASCII(cx, "attempt to write value to const field");
@@ -204,33 +368,95 @@ struct class_registration_impl {
         }(field_data.field_ptr_)
                    .transform([]() { return true; })
                    .or_else([&](const auto& error) -> result<bool> {
-                       JS_ReportErrorASCII(cx, "%s", error.data());
+                       JS_ReportErrorASCII(cx, "%s", error.c_str());
                        return false;
                    })
                    .value();
     }
 
+    static uint16_t jit_proto_id()
+    {
+        static const uint16_t id = next_jit_proto_id();
+        return id;
+    }
+
+    // built once, the specs only hold pointers to these
+    static const std::array<JSJitInfo, num_methods>& method_jit_infos()
+    {
+        static const auto infos = []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<JSJitInfo, num_methods> { make_method_jit_info<Is>(std::get<Is>(registration::methods))... };
+        }(std::make_index_sequence<num_methods> {});
+        return infos;
+    }
+
+    static const std::array<JSJitInfo, num_fields>& getter_jit_infos()
+    {
+        static const auto infos = []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<JSJitInfo, num_fields> { make_getter_jit_info<Is>(std::get<Is>(registration::fields))... };
+        }(std::make_index_sequence<num_fields> {});
+        return infos;
+    }
+
+    template <std::size_t I, typename ReturnType, typename... ArgTypes>
+    static JSJitInfo make_method_jit_info(bound_method<std::unique_ptr<generic_functor<ReturnType, ArgTypes...>>>&)
+    {
+        JSJitInfo info {};
+        info.method = jit_method_call<I>;
+        info.protoID = jit_proto_id();
+        info.depth = 0;
+        info.type_ = JSJitInfo::Method;
+        // methods may do anything to the object or the rest of the program, so nothing can be assumed
+        info.aliasSet_ = JSJitInfo::AliasEverything;
+        info.returnType_ = jit_value_type<ReturnType>();
+        return info;
+    }
+
+    template <std::size_t I, typename FieldType>
+    static JSJitInfo make_getter_jit_info(bound_field<FieldType T::*>&)
+    {
+        JSJitInfo info {};
+        info.getter = jit_field_getter<I>;
+        info.protoID = jit_proto_id();
+        info.depth = 0;
+        info.type_ = JSJitInfo::Getter;
+        // a field only changes through its setter or arbitrary calls, never through unrelated DOM-style getters
+        info.aliasSet_ = JSJitInfo::AliasDOMSets;
+        info.returnType_ = jit_value_type<FieldType>();
+        return info;
+    }
+
     template <std::size_t I, typename M>
     static JSFunctionSpec method_to_spec(bound_method<M>& method)
     {
-        return JS_FN(
-            method.name_.data(), method_call<I>, static_cast<uint16_t>(method.generic_functor_ptr_->num_args), 0);
+        if constexpr (jit_info_class<T>) {
+            return JS_FNINFO(
+                method.name_.data(), method_call<I>, &method_jit_infos()[I], static_cast<uint16_t>(method.generic_functor_ptr_->num_args), 0);
+        } else {
+            return JS_FN(
+                method.name_.data(), method_call<I>, static_cast<uint16_t>(method.generic_functor_ptr_->num_args), 0);
+        }
     }
 
     template <std::size_t I, typename FieldType>
     static JSPropertySpec field_to_spec(bound_field<FieldType T::*>& field)
     {
+        const JSJitInfo* getter_info { nullptr };
+        if constexpr (jit_info_class<T>)
+            getter_info = &getter_jit_infos()[I];
+
         if constexpr (std::is_const_v<FieldType>) {
             // this may look backwards (having a setter), but otherwise spidermonkey won't raise an error
             // when a script assigns a const value, it will just silently do nothing
             // so instead we assign a setter which simply reports an error to spidermonkey
-            return JS_PSGS(field.name_.data(), field_getter<I>, illegal_field_setter, JSPROP_PERMANENT | JSPROP_ENUMERATE);
+            return JSPropertySpec::nativeAccessors(
+                field.name_.data(), JSPROP_PERMANENT | JSPROP_ENUMERATE, field_getter<I>, getter_info, illegal_field_setter, nullptr);
         } else {
-            return JS_PSGS(field.name_.data(), field_getter<I>, field_setter<I>, JSPROP_PERMANENT | JSPROP_ENUMERATE);
+            return JSPropertySpec::nativeAccessors(
+                field.name_.data(), JSPROP_PERMANENT | JSPROP_ENUMERATE, field_getter<I>, getter_info, field_setter<I>, nullptr);
         }
     }
 
-    static void do_registration(JSContext* cx, JS::HandleObject scope)
+    static result<void> do_registration(JSContext* cx, JS::HandleObject scope)
     {
         auto methods_array = [&]<std::size_t... Is>(std::index_sequence<Is...>) {
             return std::array<JSFunctionSpec, num_methods + 1> {
@@ -242,36 +468,29 @@ struct class_registration_impl {
                 field_to_spec<Is>(std::get<Is>(registration::fields))..., JS_PS_END
             };
         }(std::make_index_sequence<num_fields> {});
-        proto_.init(
+        JSObject* proto = JS_InitClass(
             cx,
-            JS_InitClass(
-                cx,
-                scope,
-                &class_,
-                nullptr,
-                registration::name.data(),
-                &constructor,
-                registration::constructor->num_args,
-                properties_array.data(), // propertyspec - attributes
-                methods_array.data(), // functionspec - methods
-                nullptr, // static propertyspec
-                nullptr // static functionspec
-                ));
-        // proto will eventually be collected, and the finalizer will be called, so we must
-        // set the slot to nullptr so the finalizer does nothing
-        JS::SetReservedSlot(proto_, SLOT_OBJECT_PTR, JS::PrivateValue(nullptr));
-    }
+            scope,
+            &info_.class_,
+            nullptr,
+            registration::name.data(),
+            &constructor,
+            registration::constructor->num_args,
+            properties_array.data(), // propertyspec - attributes
+            methods_array.data(), // functionspec - methods
+            nullptr, // static propertyspec
+            nullptr // static functionspec
+        );
+        if (proto == nullptr) {
+            return unexpected(error::format(error_code::engine_failure, "Spidermonkey failed to register class {}", registration::name));
+        }
 
-    static void do_deregistration()
-    {
-        proto_.reset();
-    }
+        get_context_data(cx).protos_.insert_or_assign(
+            context_data::proto_key { JS::GetCurrentRealmOrNull(cx), &info_.class_ },
+            std::make_unique<JS::PersistentRootedObject>(cx, proto));
 
-    using methods_tuple = decltype(registration::methods);
-    static constexpr std::size_t num_methods = std::tuple_size_v<methods_tuple>;
-
-    using fields_tuple = decltype(registration::fields);
-    static constexpr std::size_t num_fields = std::tuple_size_v<fields_tuple>;
+        return {};
+    }
 
     static constexpr JSClassOps ops_ = []() {
         JSClassOps ops {};
@@ -281,7 +500,14 @@ struct class_registration_impl {
         return ops;
     }();
 
-    static inline const JSClass class_ { registration::name.data(), JSCLASS_HAS_RESERVED_SLOTS(SLOT_COUNT), &ops_, nullptr, nullptr, nullptr };
-    static inline JS::PersistentRootedObject proto_;
+    // jit_info classes are flagged as DOM classes, slot 0 holding the object pointer as a private value is
+    // exactly the layout spidermonkey expects of those
+    static constexpr uint32_t class_flags_ = JSCLASS_HAS_RESERVED_SLOTS(SLOT_COUNT) | (jit_info_class<T> ? JSCLASS_IS_DOMJSCLASS : 0);
+
+    static inline const registered_class_info info_ {
+        { registration::name.data(), class_flags_, &ops_, nullptr, &registered_class_extension, nullptr },
+        make_any,
+        jit_info_class<T> ? jit_proto_id : nullptr
+    };
 };
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+#pragma once
+
+// NOTE: Do not include this, include glua/backends/spidermonkey.hpp instead, the include order is carefully
+// crafted to separate declarations and dependent definitions
+
+namespace glua::spidermonkey {
+class profiler;
+
+// the points of a garbage collection reported to a gc callback
+enum class gc_progress {
+    cycle_begin,
+    slice_begin,
+    slice_end,
+    cycle_end
+};
+
+struct heap_usage {
+    std::size_t bytes_;
+    std::size_t limit_;
+};
+
+// a promise handed to JS for a value C++ produces asynchronously
+struct pending_settlement {
+    virtual ~pending_settlement() = default;
+
+    // settles the promise if the value is ready, returning whether it did
+    virtual bool try_settle(JSContext* cx) = 0;
+};
+
+// state shared by everything running on one JSContext, the backend owns it and stores it as the
+// context private so converters and callbacks, which only receive a JSContext*, can reach it
+struct context_data {
+    struct wrapper_key {
+        JS::Realm* realm_;
+        const JSClass* class_;
+        void* ptr_;
+        bool mutable_;
+
+        bool operator==(const wrapper_key&) const = default;
+    };
+
+    struct wrapper_key_hash {
+        std::size_t operator()(const wrapper_key& key) const
+        {
+            auto h = std::hash<void*> {}(key.ptr_);
+            h ^= std::hash<const void*> {}(key.class_) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<const void*> {}(key.realm_) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h ^ static_cast<std::size_t>(key.mutable_);
+        }
+    };
+
+    // called by spidermonkey after marking, the wrappers are weak so any which died are dropped
+    static void sweep_wrappers(JSTracer* trc, void* data)
+    {
+        auto* self = static_cast<context_data*>(data);
+        std::erase_if(self->wrappers_, [&](auto& entry) { return !JS_UpdateWeakPointerAfterGC(trc, &entry.second); });
+    }
+
+    struct proto_key {
+        JS::Realm* realm_;
+        const JSClass* class_;
+
+        bool operator==(const proto_key&) const = default;
+    };
+
+    struct proto_key_hash {
+        std::size_t operator()(const proto_key& key) const
+        {
+            auto h = std::hash<const void*> {}(key.class_);
+            return h ^ (std::hash<const void*> {}(key.realm_) + 0x9e3779b9 + (h << 6) + (h >> 2));
+        }
+    };
+
+    struct string_hash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view key) const
+        {
+            return std::hash<std::string_view> {}(key);
+        }
+    };
+
+    static void on_gc_slice(JSContext* cx, JS::GCProgress progress, const JS::GCDescription&)
+    {
+        auto& self = *static_cast<context_data*>(JS_GetContextPrivate(cx));
+        if (progress == JS::GC_CYCLE_END) {
+            self.check_memory_pressure(cx);
+        }
+        if (!self.gc_callback_) {
+            return;
+        }
+
+        switch (progress) {
+        case JS::GC_CYCLE_BEGIN:
+            self.gc_callback_(gc_progress::cycle_begin);
+            break;
+        case JS::GC_SLICE_BEGIN:
+            self.gc_callback_(gc_progress::slice_begin);
+            break;
+        case JS::GC_SLICE_END:
+            self.gc_callback_(gc_progress::slice_end);
+            break;
+        case JS::GC_CYCLE_END:
+            self.gc_callback_(gc_progress::cycle_end);
+            break;
+        }
+    }
+
+    static void on_out_of_memory(JSContext*, void* data)
+    {
+        static_cast<context_data*>(data)->out_of_memory_ = true;
+    }
+
+    // returning false terminates the running script, which spidermonkey asks for once an interrupt is requested
+    static bool on_interrupt(JSContext* cx)
+    {
+        auto& self = *static_cast<context_data*>(JS_GetContextPrivate(cx));
+        self.deliver_memory_pressure();
+        self.sample_profiler();
+        return !self.deadline_expired_;
+    }
+
+    static heap_usage get_heap_usage(JSContext* cx)
+    {
+        return { JS_GetGCParameter(cx, JSGC_BYTES), JS_GetGCParameter(cx, JSGC_MAX_BYTES) };
+    }
+
+    // what survives a collection is what the heap really holds, so pressure is checked when one ends. The
+    // callback itself is deferred until the collection is over, as shedding load will want to use the engine
+    void check_memory_pressure(JSContext* cx)
+    {
+        if (!memory_pressure_callback_) {
+            return;
+        }
+
+        auto usage = get_heap_usage(cx);
+        if (static_cast<double>(usage.bytes_) >= static_cast<double>(usage.limit_) * memory_pressure_threshold_) {
+            pending_memory_pressure_ = usage;
+            JS_RequestInterruptCallback(cx);
+        }
+    }
+
+    // runs a memory pressure callback deferred from a collection, never from inside one
+    void deliver_memory_pressure()
+    {
+        if (auto usage = std::exchange(pending_memory_pressure_, std::nullopt); usage && memory_pressure_callback_) {
+            memory_pressure_callback_(*usage);
+        }
+    }
+
+    std::function<void(gc_progress)> gc_callback_;
+
+    std::function<void(heap_usage)> memory_pressure_callback_;
+    double memory_pressure_threshold_ { 1.0 };
+    std::optional<heap_usage> pending_memory_pressure_;
+
+    // set when an allocation failed, so the failing call reports it rather than a generic error
+    bool out_of_memory_ { false };
+
+    // promises returned for futures, settled from run_pending_jobs
+    std::vector<std::unique_ptr<pending_settlement>> pending_settlements_;
+
+    // set while a profiler is running
+    js::ProfilingStack* profiling_stack_ { nullptr };
+    profiler* profiler_ { nullptr };
+
+    // takes the sample the running profiler asked for, if any. Only called on the context's own thread
+    void sample_profiler();
+
+    // names of registered functors, which their functions refer to for profiler labels. Keyed by functor,
+    // so registering the same functor under the same name again (in every sandbox, say) reuses the entry
+    std::set<std::pair<const void*, std::string>> functor_names_;
+
+    // set by the watchdog thread when the running call's deadline passed
+    std::atomic<bool> deadline_expired_ { false };
+
+    JSObject* find_proto(JS::Realm* realm, const JSClass* clasp) const
+    {
+        auto pos = protos_.find(proto_key { realm, clasp });
+        return pos != protos_.end() ? pos->second->get() : nullptr;
+    }
+
+    // drops the prototypes of a realm which is going away, so they no longer keep its global alive
+    void release_realm(JS::Realm* realm)
+    {
+        std::erase_if(protos_, [&](const auto& entry) { return entry.first.realm_ == realm; });
+    }
+
+    // the prototype of every registered class, per realm it was registered in. Wrappers must be created
+    // with the prototype from their own realm, and other contexts have prototypes of their own
+    std::unordered_map<proto_key, std::unique_ptr<JS::PersistentRootedObject>, proto_key_hash> protos_;
+
+    // live wrapper objects by C++ object, so the same object reaches JS as the same JS object
+    std::unordered_map<wrapper_key, JS::Heap<JSObject*>, wrapper_key_hash> wrappers_;
+
+    // property ids for names used when building objects. The atoms are pinned, pinned atoms are never
+    // collected so the ids don't need tracing. Capped, as pinned atoms live as long as the runtime
+    static constexpr std::size_t max_pinned_keys { 4096 };
+    std::unordered_map<std::string, jsid, string_hash, std::equal_to<>> pinned_keys_;
+};
+
+inline context_data& get_context_data(JSContext* cx)
+{
+    return *static_cast<context_data*>(JS_GetContextPrivate(cx));
+}
+
+// the error for a failed engine call. The pending exception is cleared so the context stays usable, and
+// a failure caused by reaching the heap limit is reported as such
+inline unexpected engine_failure(JSContext* cx, error_literal message)
+{
+    JS_ClearPendingException(cx);
+    if (std::exchange(get_context_data(cx).out_of_memory_, false)) {
+        return unexpected(error { error_code::out_of_memory, "Spidermonkey ran out of memory, the heap limit was reached" });
+    }
+
+    return unexpected(error { error_code::engine_failure, message });
+}
+
+// as above, with the message formatted from format and args only if it is read
+template <typename Arg, typename... Args>
+unexpected engine_failure(JSContext* cx, std::format_string<Arg, Args...> format, Arg&& arg, Args&&... args)
+{
+    JS_ClearPendingException(cx);
+    if (std::exchange(get_context_data(cx).out_of_memory_, false)) {
+        return unexpected(error { error_code::out_of_memory, "Spidermonkey ran out of memory, the heap limit was reached" });
+    }
+
+    return unexpected(error::format(error_code::engine_failure, format, std::forward<Arg>(arg), std::forward<Args>(args)...));
+}
+}
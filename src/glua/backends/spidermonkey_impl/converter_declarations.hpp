@@ -10,8 +10,8 @@ result<JS::Value> to_js(JSContext* cx, T&& value);
 template <typename ReturnType, typename... ArgTypes>
 bool call_generic_wrapped_functor(generic_functor<ReturnType, ArgTypes...>& f, JSContext* cx, JS::CallArgs& args);
 
-template <typename ReturnType, typename ClassType, typename... ArgTypes>
-bool call_generic_wrapped_method(generic_functor<ReturnType, ClassType, ArgTypes...>& f, JSContext* cx, JS::CallArgs& args);
+template <typename ReturnType, typename ClassType, typename... ArgTypes, typename Args>
+bool call_generic_wrapped_method(generic_functor<ReturnType, ClassType, ArgTypes...>& f, JSContext* cx, JS::HandleValue thisv, Args& args);
 
 template <typename T>
 struct converter {
@@ -24,13 +24,50 @@ struct converter<T> {
     static result<std::string> from_js(JSContext* cx, JS::HandleValue v);
 };
 
+// the argument type produced for std::string_view parameters. Bound function arguments that are ASCII
+// are viewed in place, through chars kept stable by apply_from_js for the whole call. Anything else, and
+// any view converted outside of a call, is converted to UTF-8 and owned here
+class string_view_arg {
+public:
+    explicit string_view_arg(std::string_view view)
+        : value_(view)
+    {
+    }
+
+    explicit string_view_arg(std::string owned)
+        : value_(std::move(owned))
+    {
+    }
+
+    operator std::string_view() const
+    {
+        return std::visit([](const auto& v) { return std::string_view { v }; }, value_);
+    }
+
+private:
+    std::variant<std::string_view, std::string> value_;
+};
+
 template <decays_to<std::string_view> T>
 struct converter<T> {
     static result<JS::Value> to_js(JSContext* cx, std::string_view v);
 
-    // from_js not supported, can't 'point' to JS bytes
+    static result<string_view_arg> from_js(JSContext* cx, JS::HandleValue v);
+};
+
+// a moved-in std::u16string is handed to spidermonkey as an external string without copying, the
+// string's buffer is released when the JS string is finalized
+template <>
+struct converter<std::u16string> {
+    static result<JS::Value> to_js(JSContext* cx, std::u16string&& v);
+    static result<JS::Value> to_js(JSContext* cx, const std::u16string& v);
+
+    static result<std::u16string> from_js(JSContext* cx, JS::HandleValue v);
 };
 
+template <decays_to<std::u16string> T>
+struct converter<T> : converter<std::u16string> { };
+
 template <decays_to<const char*> T>
 struct converter<T> {
     static result<JS::Value> to_js(JSContext* cx, const char* v);
@@ -49,6 +86,48 @@ struct converter<std::vector<T>> {
     static result<std::vector<T>> from_js(JSContext* cx, JS::HandleValue v);
 };
 
+// numeric element types which have a matching typed array
+template <typename T>
+concept typed_array_element = std::same_as<T, int8_t> || std::same_as<T, uint8_t> || std::same_as<T, int16_t>
+    || std::same_as<T, uint16_t> || std::same_as<T, int32_t> || std::same_as<T, uint32_t> || std::same_as<T, float>
+    || std::same_as<T, double>;
+
+// opts a numeric vector into converting to and from the matching typed array with a single copy, rather
+// than boxing every element into a generic array the way a plain std::vector is
+template <typed_array_element T>
+struct typed_array {
+    std::vector<T> values_;
+};
+
+template <typename T>
+struct is_typed_array : std::false_type { };
+
+template <typename T>
+struct is_typed_array<typed_array<T>> : std::true_type { };
+
+template <typed_array_element T>
+struct converter<typed_array<T>> {
+    static result<JS::Value> to_js(JSContext* cx, const typed_array<T>& v);
+
+    // accepts a typed array of the same element type, or falls back to a generic array
+    static result<typed_array<T>> from_js(JSContext* cx, JS::HandleValue v);
+};
+
+template <typename T>
+    requires(!is_typed_array<T>::value && is_typed_array<std::decay_t<T>>::value)
+struct converter<T> : converter<std::decay_t<T>> { };
+
+// a span argument points directly at the typed array's memory for the duration of the call. The data is
+// moved out of line before the span is taken, so converting later arguments or calling back into the
+// engine can't move it under the span
+template <typename T>
+    requires typed_array_element<std::remove_const_t<T>>
+struct converter<std::span<T>> {
+    static result<JS::Value> to_js(JSContext* cx, std::span<T> v);
+
+    static result<std::span<T>> from_js(JSContext* cx, JS::HandleValue v);
+};
+
 template <decays_to_vector T>
 struct converter<T> {
     static result<JS::Value> to_js(JSContext* cx, T v);
@@ -62,6 +141,10 @@ struct converter<std::unordered_map<std::string, T>> {
     static result<JS::Value> to_js(JSContext* cx, const std::unordered_map<std::string, T>& v);
 
     static result<std::unordered_map<std::string, T>> from_js(JSContext* cx, JS::HandleValue v);
+
+    // replaces the contents of out, reusing its bucket storage. Only own enumerable data properties are
+    // read, getters are never invoked
+    static result<void> from_js_into(JSContext* cx, JS::HandleValue v, std::unordered_map<std::string, T>& out);
 };
 
 template <decays_to_unordered_map T>
@@ -71,6 +154,13 @@ struct converter<T> {
     // don't support from_js as it's a reference to a map
 };
 
+// a future becomes a promise, which is settled by run_pending_jobs once the future is ready. A future
+// holding an exception rejects the promise with the exception's message
+template <typename T>
+struct converter<std::future<T>> {
+    static result<JS::Value> to_js(JSContext* cx, std::future<T>&& v);
+};
+
 template <>
 struct converter<int8_t> {
     static result<JS::Value> to_js(JSContext*, int8_t v);
@@ -225,11 +315,9 @@ using ValueFor = JS::Value;
 template <typename... Ts>
 auto many_to_js([[maybe_unused]] JSContext* cx, Ts&&... values);
 
-template <typename T>
-using HandleValueFor = JS::HandleValue;
-
-template <typename... Ts>
-auto many_from_js([[maybe_unused]] JSContext* cx, HandleValueFor<Ts>... vs);
+// converts values(I), values(I + 1), ... to the remaining Ts and calls f with everything converted so far
+template <typename R, std::size_t I, typename... Ts, typename Values, typename F, typename... Converted>
+R apply_from_js(JSContext* cx, const Values& values, F&& f, Converted&&... converted);
 
 template <typename T>
 result<JS::Value> to_js(JSContext* cx, T&& value)
@@ -240,10 +328,27 @@ result<JS::Value> to_js(JSContext* cx, T&& value)
 ////////////////////////////////////////////////////////////////////
 // THESE HELPERS MUST ALWAYS BE THE LAST DEFINITIONS IN THIS FILE //
 ////////////////////////////////////////////////////////////////////
+inline bool is_ascii(std::string_view v)
+{
+    return std::all_of(v.begin(), v.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+// ascii is valid latin-1, which spidermonkey stores as-is, anything else has to be inflated from UTF-8
+inline result<JS::Value> string_to_js(JSContext* cx, std::string_view v)
+{
+    JSString* str = is_ascii(v) ? JS_NewStringCopyN(cx, v.data(), v.size())
+                                : JS_NewStringCopyUTF8N(cx, JS::UTF8Chars { v.data(), v.size() });
+    if (str == nullptr) {
+        return unexpected(error { error_code::engine_failure, "Could not create js string" });
+    }
+
+    return JS::StringValue(str);
+}
+
 template <decays_to<std::string> T>
 result<JS::Value> converter<T>::to_js(JSContext* cx, const std::string& v)
 {
-    return JS::StringValue(JS_NewStringCopyN(cx, v.data(), v.size()));
+    return string_to_js(cx, v);
 }
 
 template <typename T>
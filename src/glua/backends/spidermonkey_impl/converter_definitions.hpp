@@ -4,33 +4,162 @@
 // crafted to separate declarations and dependent definitions
 
 namespace glua::spidermonkey {
-template <decays_to<std::string> T>
-result<std::string> converter<T>::from_js(JSContext* cx, JS::HandleValue v)
+// converts v to a string and flattens it, so its chars can be read directly
+inline JSLinearString* linear_string_from_js(JSContext* cx, JS::HandleValue v)
 {
     JS::RootedString str { cx, JS::ToString(cx, v) };
-    auto size = JS_GetStringEncodingLength(cx, str);
-    std::string retval;
-    retval.resize(size);
-    if (!JS_EncodeStringToBuffer(cx, str, retval.data(), size)) {
-        return unexpected("Could not encode js string to buffer");
+    if (!str) {
+        return nullptr;
     }
 
-    // might contain '\0' that we still need to trim...?
+    return JS_EnsureLinearString(cx, str);
+}
+
+// the chars of an ascii latin-1 string, which are also its UTF-8 encoding. Only valid while no GC can run
+inline std::optional<std::string_view> ascii_chars(JSLinearString* str, const JS::AutoRequireNoGC& nogc)
+{
+    if (!JS::LinearStringHasLatin1Chars(str)) {
+        return std::nullopt;
+    }
 
+    std::string_view chars { reinterpret_cast<const char*>(JS::GetLatin1LinearStringChars(nogc, str)), JS::GetLinearStringLength(str) };
+    if (!is_ascii(chars)) {
+        return std::nullopt;
+    }
+
+    return chars;
+}
+
+inline std::string utf8_from_linear_string(JSLinearString* str)
+{
+    {
+        JS::AutoCheckCannotGC nogc;
+        if (auto chars = ascii_chars(str, nogc)) {
+            return std::string { *chars };
+        }
+    }
+
+    std::string retval;
+    retval.resize(JS::GetDeflatedUTF8StringLength(str));
+    retval.resize(JS::DeflateStringToUTF8Buffer(str, mozilla::Span<char> { retval.data(), retval.size() }));
     return retval;
 }
 
+template <decays_to<std::string> T>
+result<std::string> converter<T>::from_js(JSContext* cx, JS::HandleValue v)
+{
+    JSLinearString* str = linear_string_from_js(cx, v);
+    if (str == nullptr) {
+        return unexpected(error { error_code::conversion_failed, "Could not convert value to string" });
+    }
+
+    return utf8_from_linear_string(str);
+}
+
 template <decays_to<std::string_view> T>
 result<JS::Value> converter<T>::to_js(JSContext* cx, std::string_view v)
 {
-    return JS::StringValue(JS_NewStringCopyN(cx, v.data(), v.size()));
+    return string_to_js(cx, v);
+}
+
+template <decays_to<std::string_view> T>
+result<string_view_arg> converter<T>::from_js(JSContext* cx, JS::HandleValue v)
+{
+    JSLinearString* str = linear_string_from_js(cx, v);
+    if (str == nullptr) {
+        return unexpected(error { error_code::conversion_failed, "Could not convert value to string" });
+    }
+
+    // nothing keeps the chars in place once this returns, so they're copied. Call arguments are viewed
+    // through string_view_from_js instead
+    return string_view_arg { utf8_from_linear_string(str) };
+}
+
+// views the chars of an ASCII string in place. chars keeps the string alive and its chars where they are,
+// copying them out of the nursery or out of an inline string when they'd move, so the view is valid for as
+// long as chars is. Other strings are converted to UTF-8
+inline result<string_view_arg> string_view_from_js(JSContext* cx, JS::HandleValue v, JS::AutoStableStringChars& chars)
+{
+    JS::RootedString str { cx, JS::ToString(cx, v) };
+    if (!str || !chars.init(cx, str)) {
+        return unexpected(error { error_code::conversion_failed, "Could not convert value to string" });
+    }
+
+    if (chars.isLatin1()) {
+        auto range = chars.latin1Range();
+        std::string_view view { reinterpret_cast<const char*>(range.begin().get()), range.length() };
+        if (is_ascii(view)) {
+            return string_view_arg { view };
+        }
+    }
+
+    // init flattened the string, so this can't GC
+    return string_view_arg { utf8_from_linear_string(JS_EnsureLinearString(cx, str)) };
 }
 
 template <decays_to<const char*> T>
 result<JS::Value> converter<T>::to_js(JSContext* cx, const char* v)
 {
-    std::string_view view { v };
-    return JS::StringValue(JS_NewStringCopyN(cx, view.data(), view.size()));
+    return string_to_js(cx, v);
+}
+
+// owns the chars of an external string, spidermonkey calls finalize once the JS string is collected
+struct external_u16string final : JSExternalStringCallbacks {
+    explicit external_u16string(std::u16string value)
+        : value_(std::move(value))
+    {
+    }
+
+    void finalize(char16_t*) const override
+    {
+        delete this;
+    }
+
+    std::size_t sizeOfBuffer(const char16_t*, mozilla::MallocSizeOf) const override
+    {
+        return value_.capacity() * sizeof(char16_t);
+    }
+
+    std::u16string value_;
+};
+
+inline result<JS::Value> converter<std::u16string>::to_js(JSContext* cx, std::u16string&& v)
+{
+    if (v.empty()) {
+        return JS::StringValue(JS_GetEmptyString(cx));
+    }
+
+    auto* external = new external_u16string { std::move(v) };
+    JSString* str = JS_NewExternalString(cx, external->value_.data(), external->value_.size(), external);
+    if (str == nullptr) {
+        delete external;
+        return unexpected(error { error_code::engine_failure, "Could not create external js string" });
+    }
+
+    return JS::StringValue(str);
+}
+
+inline result<JS::Value> converter<std::u16string>::to_js(JSContext* cx, const std::u16string& v)
+{
+    JSString* str = JS_NewUCStringCopyN(cx, v.data(), v.size());
+    if (str == nullptr) {
+        return unexpected(error { error_code::engine_failure, "Could not create js string" });
+    }
+
+    return JS::StringValue(str);
+}
+
+inline result<std::u16string> converter<std::u16string>::from_js(JSContext* cx, JS::HandleValue v)
+{
+    JSLinearString* str = linear_string_from_js(cx, v);
+    if (str == nullptr) {
+        return unexpected(error { error_code::conversion_failed, "Could not convert value to string" });
+    }
+
+    std::u16string retval;
+    retval.resize(JS::GetLinearStringLength(str));
+    JS::CopyLinearStringChars(retval.data(), str, retval.size());
+    return retval;
 }
 
 template <decays_to_vector T>
@@ -299,7 +428,7 @@ result<JS::Value> converter<std::vector<T>>::to_js(JSContext* cx, const std::vec
 }
 
 template <typename T>
-result<std::vector<T>> converter<std::vector<T>>::from_js(JSContext* cx, JS::HandleValue v)
+result<std::vector<T>> elements_from_js(JSContext* cx, JS::HandleValue v)
 {
     if (v.isObject()) {
         bool is_array { false };
@@ -320,99 +449,386 @@ result<std::vector<T>> converter<std::vector<T>>::from_js(JSContext* cx, JS::Han
                             return unexpected(std::move(inner_result).error());
                         }
                     } else {
-                        return unexpected("Could not get array element");
+                        return unexpected(error { error_code::conversion_failed, "Could not get array element" });
                     }
                 }
 
                 return result;
             } else {
-                return unexpected("Could not get size of array");
+                return unexpected(error { error_code::conversion_failed, "Could not get size of array" });
             }
         } else {
-            return unexpected("Could not build vector from non-array object");
+            return unexpected(error { error_code::conversion_failed, "Could not build vector from non-array object" });
         }
     } else {
-        return unexpected("Could not convert non-object to array");
+        return unexpected(error { error_code::conversion_failed, "Could not convert non-object to array" });
     }
 }
 
 template <typename T>
-result<JS::Value> converter<std::unordered_map<std::string, T>>::to_js(JSContext* cx, std::unordered_map<std::string, T>&& v)
+result<std::vector<T>> converter<std::vector<T>>::from_js(JSContext* cx, JS::HandleValue v)
+{
+    return elements_from_js<T>(cx, v);
+}
+
+template <typename T>
+struct typed_array_traits;
+
+#define GLUA_TYPED_ARRAY_TRAITS(type, name)                                    \
+    template <>                                                                \
+    struct typed_array_traits<type> {                                          \
+        static constexpr js::Scalar::Type scalar_type = js::Scalar::name;      \
+        static JSObject* create(JSContext* cx, std::size_t length)             \
+        {                                                                      \
+            return JS_New##name##Array(cx, length);                            \
+        }                                                                      \
+    };
+
+GLUA_TYPED_ARRAY_TRAITS(int8_t, Int8)
+GLUA_TYPED_ARRAY_TRAITS(uint8_t, Uint8)
+GLUA_TYPED_ARRAY_TRAITS(int16_t, Int16)
+GLUA_TYPED_ARRAY_TRAITS(uint16_t, Uint16)
+GLUA_TYPED_ARRAY_TRAITS(int32_t, Int32)
+GLUA_TYPED_ARRAY_TRAITS(uint32_t, Uint32)
+GLUA_TYPED_ARRAY_TRAITS(float, Float32)
+GLUA_TYPED_ARRAY_TRAITS(double, Float64)
+
+#undef GLUA_TYPED_ARRAY_TRAITS
+
+// the typed array behind v if it is a typed array of exactly T
+template <typed_array_element T>
+JSObject* typed_array_view(JS::HandleValue v)
+{
+    if (!v.isObject()) {
+        return nullptr;
+    }
+
+    JSObject* view = js::UnwrapArrayBufferView(&v.toObject());
+    if (view == nullptr || JS_GetArrayBufferViewType(view) != typed_array_traits<T>::scalar_type) {
+        return nullptr;
+    }
+
+    return view;
+}
+
+// the typed array's elements if v is a typed array of exactly T, the view only stays valid while no GC can
+// run unless the data was first moved out of line with JS::EnsureNonInlineArrayBufferOrView
+template <typed_array_element T>
+std::optional<std::span<T>> typed_array_data(JS::HandleValue v, const JS::AutoRequireNoGC& nogc)
+{
+    JSObject* view = typed_array_view<T>(v);
+    if (view == nullptr) {
+        return std::nullopt;
+    }
+
+    bool is_shared { false };
+    auto* data = static_cast<T*>(JS_GetArrayBufferViewData(view, &is_shared, nogc));
+    if (is_shared) {
+        // shared memory can change under us, only copying reads are safe
+        return std::nullopt;
+    }
+
+    return std::span<T> { data, JS_GetTypedArrayLength(view) };
+}
+
+template <typed_array_element T>
+result<JS::Value> typed_array_to_js(JSContext* cx, std::span<const T> v)
+{
+    JS::RootedObject array { cx, typed_array_traits<T>::create(cx, v.size()) };
+    if (!array) {
+        return unexpected(error { error_code::engine_failure, "Could not allocate typed array" });
+    }
+
+    if (!v.empty()) {
+        JS::AutoCheckCannotGC nogc;
+        bool is_shared { false };
+        std::memcpy(JS_GetArrayBufferViewData(array, &is_shared, nogc), v.data(), v.size_bytes());
+    }
+
+    return JS::ObjectValue(*array);
+}
+
+template <typed_array_element T>
+result<JS::Value> converter<typed_array<T>>::to_js(JSContext* cx, const typed_array<T>& v)
+{
+    return typed_array_to_js<T>(cx, v.values_);
+}
+
+template <typed_array_element T>
+result<typed_array<T>> converter<typed_array<T>>::from_js(JSContext* cx, JS::HandleValue v)
+{
+    {
+        JS::AutoCheckCannotGC nogc;
+        if (auto data = typed_array_data<T>(v, nogc)) {
+            return typed_array<T> { std::vector<T>(data->begin(), data->end()) };
+        }
+    }
+
+    return elements_from_js<T>(cx, v).transform([](std::vector<T>&& values) { return typed_array<T> { std::move(values) }; });
+}
+
+template <typename T>
+    requires typed_array_element<std::remove_const_t<T>>
+result<JS::Value> converter<std::span<T>>::to_js(JSContext* cx, std::span<T> v)
 {
+    return typed_array_to_js<std::remove_const_t<T>>(cx, v);
+}
+
+template <typename T>
+    requires typed_array_element<std::remove_const_t<T>>
+result<std::span<T>> converter<std::span<T>>::from_js(JSContext* cx, JS::HandleValue v)
+{
+    // small typed arrays keep their elements inside the object, where a GC moves them. The view stays
+    // alive through v for the whole call, so once its data is out of line the span can't dangle
+    if (JSObject* view = typed_array_view<std::remove_const_t<T>>(v)) {
+        JS::RootedObject rooted { cx, view };
+        if (!JS::EnsureNonInlineArrayBufferOrView(cx, rooted)) {
+            JS_ClearPendingException(cx);
+            return unexpected(error { error_code::out_of_memory, "Could not move typed array data out of line" });
+        }
+    }
+
+    JS::AutoCheckCannotGC nogc;
+    if (auto data = typed_array_data<std::remove_const_t<T>>(v, nogc)) {
+        return std::span<T> { *data };
+    }
+
+    return unexpected(error { error_code::conversion_failed, "Could not convert value to span, expected an unshared typed array of the matching element type" });
+}
+
+// the id for a property name. Ascii names are atomized once per context and pinned, so building many
+// objects with the same keys doesn't atomize every key again
+inline bool property_key_for(JSContext* cx, std::string_view name, JS::MutableHandleId id)
+{
+    auto& pinned_keys = get_context_data(cx).pinned_keys_;
+    if (auto it = pinned_keys.find(name); it != pinned_keys.end()) {
+        id.set(it->second);
+        return true;
+    }
+
+    if (is_ascii(name) && pinned_keys.size() < context_data::max_pinned_keys) {
+        JS::RootedString atom { cx, JS_AtomizeAndPinStringN(cx, name.data(), name.size()) };
+        if (!atom || !JS_StringToId(cx, atom, id)) {
+            return false;
+        }
+
+        pinned_keys.emplace(name, id.get());
+        return true;
+    }
+
+    return string_to_js(cx, name)
+        .transform([&](JS::Value str) {
+            JS::RootedString rooted { cx, str.toString() };
+            return JS_StringToId(cx, rooted, id);
+        })
+        .value_or(false);
+}
+
+// builds a plain object from a map, Map is deduced as a value type when the values may be moved from
+template <typename Map>
+result<JS::Value> object_from_map(JSContext* cx, Map&& v)
+{
+    // define properties in a canonical order, so maps with the same keys end up with the same shape and
+    // every object after the first follows the shape transitions already cached by spidermonkey
+    std::vector<decltype(&*v.begin())> entries;
+    entries.reserve(v.size());
+    for (auto& entry : v) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) { return lhs->first < rhs->first; });
+
     JS::RootedObject js_obj { cx, JS_NewPlainObject(cx) };
+    if (!js_obj) {
+        return unexpected(error { error_code::engine_failure, "Could not allocate object" });
+    }
+
+    JS::RootedId id { cx };
+    JS::RootedValue value { cx };
+    for (auto* entry : entries) {
+        if (!property_key_for(cx, entry->first, &id)) {
+            return unexpected(error::format(error_code::engine_failure, "Could not create property key {}", entry->first));
+        }
 
-    for (auto& [key, value] : v) {
-        auto result = spidermonkey::to_js(cx, std::move(value)).transform([&](auto value_value) {
-            JS::RootedValue rooted_value { cx, value_value };
-            JS_SetProperty(cx, js_obj, key.data(), rooted_value);
-        });
-        if (!result.has_value())
-            return unexpected(std::move(result).error());
+        auto converted = [&]() {
+            if constexpr (std::is_lvalue_reference_v<Map>) {
+                return spidermonkey::to_js(cx, entry->second);
+            } else {
+                return spidermonkey::to_js(cx, std::move(entry->second));
+            }
+        }();
+        if (!converted.has_value()) {
+            return unexpected(std::move(converted).error());
+        }
+
+        value.set(converted.value());
+        if (!JS_DefinePropertyById(cx, js_obj, id, value, JSPROP_ENUMERATE)) {
+            return unexpected(error::format(error_code::engine_failure, "Could not define property {}", entry->first));
+        }
     }
 
-    return JS::ObjectOrNullValue(js_obj);
+    return JS::ObjectValue(*js_obj);
+}
+
+template <typename T>
+result<JS::Value> converter<std::unordered_map<std::string, T>>::to_js(JSContext* cx, std::unordered_map<std::string, T>&& v)
+{
+    return object_from_map(cx, std::move(v));
 }
 
 template <typename T>
 result<JS::Value> converter<std::unordered_map<std::string, T>>::to_js(JSContext* cx, const std::unordered_map<std::string, T>& v)
 {
-    JS::RootedObject js_obj { cx, JS_NewPlainObject(cx) };
+    return object_from_map(cx, v);
+}
 
-    for (const auto& [key, value] : v) {
-        auto result = spidermonkey::to_js(cx, value).transform([&](auto value_value) {
-            JS::RootedValue rooted_value { cx, value_value };
-            JS_SetProperty(cx, js_obj, key.data(), rooted_value);
-        });
-        if (!result.has_value())
-            return unexpected(std::move(result).error());
+// writes the name of id into key, reusing its storage. Returns false for ids which aren't names (symbols)
+inline bool property_name_for(JS::HandleId id, std::string& key)
+{
+    if (id.isInt()) {
+        char buffer[16];
+        auto [end, ec] = std::to_chars(std::begin(buffer), std::end(buffer), id.toInt());
+        key.assign(buffer, end);
+        return true;
+    }
+
+    if (!id.isString()) {
+        return false;
+    }
+
+    JSLinearString* str = id.toLinearString();
+    {
+        JS::AutoCheckCannotGC nogc;
+        if (auto chars = ascii_chars(str, nogc)) {
+            key.assign(*chars);
+            return true;
+        }
     }
 
-    return JS::ObjectOrNullValue(js_obj);
+    key = utf8_from_linear_string(str);
+    return true;
 }
 
 template <typename T>
 result<std::unordered_map<std::string, T>> converter<std::unordered_map<std::string, T>>::from_js(JSContext* cx, JS::HandleValue v)
 {
-    if (v.isObject()) {
-        JS::RootedObject map_obj { cx, &v.toObject() };
-        std::unordered_map<std::string, T> map;
-
-        JS::Rooted<JS::IdVector> ids { cx, JS::IdVector(cx) };
-
-        if (JS_Enumerate(cx, map_obj, &ids)) {
-            const std::size_t length = ids.length();
-            map.reserve(length);
-            for (std::size_t i = 0; i < length; ++i) {
-                JS::RootedId element_id { cx, ids[i] };
-                JS::RootedValue element_value { cx };
-
-                if (JS_GetPropertyById(cx, map_obj, element_id, &element_value)) {
-                    JS::RootedString key_str { cx, element_id.toString() };
-                    auto key_str_size = JS_GetStringEncodingLength(cx, key_str);
-                    std::string key_str_cpp;
-                    key_str_cpp.resize(key_str_size);
-                    if (!JS_EncodeStringToBuffer(cx, key_str, key_str_cpp.data(), key_str_size)) {
-                        return unexpected("Could not encode property key to buffer");
-                    }
+    std::unordered_map<std::string, T> map;
+    return from_js_into(cx, v, map).transform([&]() { return std::move(map); });
+}
 
-                    auto value_result = spidermonkey::from_js<T>(cx, element_value);
-                    if (value_result.has_value()) {
-                        map.emplace(std::move(key_str_cpp), std::move(value_result).value());
-                    } else {
-                        return unexpected("Could not convert property value to the requested typed");
-                    }
-                } else {
-                    return unexpected("Could not retrieve property value");
-                }
-            }
+template <typename T>
+result<void> converter<std::unordered_map<std::string, T>>::from_js_into(JSContext* cx, JS::HandleValue v, std::unordered_map<std::string, T>& out)
+{
+    if (!v.isObject()) {
+        return unexpected(error { error_code::conversion_failed, "Could not convert non-object to map" });
+    }
+
+    JS::RootedObject map_obj { cx, &v.toObject() };
+    JS::Rooted<JS::IdVector> ids { cx, JS::IdVector(cx) };
+    if (!JS_Enumerate(cx, map_obj, &ids)) {
+        return unexpected(error { error_code::conversion_failed, "Could not enumerate object in map conversion" });
+    }
+
+    out.clear();
+    out.reserve(ids.length());
+
+    JS::RootedId id { cx };
+    JS::Rooted<mozilla::Maybe<JS::PropertyDescriptor>> descriptor { cx };
+    JS::RootedValue element_value { cx };
+    std::string key;
+    for (std::size_t i = 0; i < ids.length(); ++i) {
+        id = ids[i];
+
+        // an own property lookup, which neither walks the prototype chain nor runs getters
+        if (!JS_GetOwnPropertyDescriptorById(cx, map_obj, id, &descriptor)) {
+            return unexpected(error { error_code::conversion_failed, "Could not retrieve property value" });
+        }
+        if (descriptor.get().isNothing() || !descriptor.get()->isDataDescriptor() || !property_name_for(id, key)) {
+            continue;
+        }
+
+        element_value = descriptor.get()->value();
+        auto value_result = spidermonkey::from_js<T>(cx, element_value);
+        if (!value_result.has_value()) {
+            return unexpected(error::format(error_code::conversion_failed, "Could not convert property {} to the requested type: {}", key, value_result.error()));
+        }
 
-            return map;
+        out.emplace(key, std::move(value_result).value());
+    }
+
+    return {};
+}
+
+template <typename T>
+class future_settlement final : public pending_settlement {
+public:
+    future_settlement(JSContext* cx, JS::HandleObject promise, std::future<T> future)
+        : promise_(cx, promise)
+        , future_(std::move(future))
+    {
+    }
+
+    bool try_settle(JSContext* cx) override
+    {
+        // a deferred future is never ready on its own, it runs when its value is taken
+        if (future_.wait_for(std::chrono::seconds { 0 }) == std::future_status::timeout) {
+            return false;
+        }
+
+        JSAutoRealm auto_realm { cx, promise_ };
+
+        JS::RootedValue settled { cx };
+        auto value = take_value(cx);
+        bool success { false };
+        if (value.has_value()) {
+            settled = value.value();
+            success = JS::ResolvePromise(cx, promise_, settled);
         } else {
-            return unexpected("Could not enumerate object in map conversion");
+            settled = string_to_js(cx, value.error().message()).value_or(JS::UndefinedValue());
+            success = JS::RejectPromise(cx, promise_, settled);
         }
-    } else {
-        return unexpected("Could not convert non-object to map");
+
+        if (!success) {
+            JS_ClearPendingException(cx);
+        }
+
+        return true;
+    }
+
+private:
+    result<JS::Value> take_value(JSContext* cx)
+    {
+        try {
+            if constexpr (std::same_as<T, void>) {
+                future_.get();
+                return JS::UndefinedValue();
+            } else {
+                return spidermonkey::to_js(cx, future_.get());
+            }
+        } catch (const std::exception& e) {
+            return unexpected(std::string { e.what() });
+        } catch (...) {
+            return unexpected(error { "Asynchronous functor failed with an unknown exception" });
+        }
+    }
+
+    JS::PersistentRootedObject promise_;
+    std::future<T> future_;
+};
+
+template <typename T>
+result<JS::Value> converter<std::future<T>>::to_js(JSContext* cx, std::future<T>&& v)
+{
+    if (!v.valid()) {
+        return unexpected(error { error_code::conversion_failed, "Could not convert a future without a shared state to a promise" });
     }
+
+    JS::RootedObject promise { cx, JS::NewPromiseObject(cx, nullptr) };
+    if (!promise) {
+        return unexpected(error { error_code::engine_failure, "Could not allocate promise" });
+    }
+
+    get_context_data(cx).pending_settlements_.push_back(std::make_unique<future_settlement<T>>(cx, promise, std::move(v)));
+    return JS::ObjectValue(*promise);
 }
 
 inline result<JS::Value> converter<any>::to_js(JSContext* cx, const any& v)
@@ -421,7 +837,7 @@ inline result<JS::Value> converter<any>::to_js(JSContext* cx, const any& v)
     if (spidermonkey_any) {
         return spidermonkey_any->to_js(cx);
     } else {
-        return unexpected("Received invalid any, perhaps from another backend");
+        return unexpected(error { error_code::conversion_failed, "Received invalid any, perhaps from another backend" });
     }
 }
 
@@ -451,14 +867,10 @@ inline result<any> converter<any>::from_js(JSContext* cx, JS::HandleValue v)
             // if array make vector<any> (any_array_impl)
             // if map make unordered_map<std::string, any> (any_map_impl)
             auto& obj = v.toObject();
-            auto* c = JS::GetClass(&obj);
             bool is_array { false };
 
-            if (JSCLASS_RESERVED_SLOTS(c) == SLOT_COUNT) {
-                // if it has our SLOT_COUNT it's (probably) a registered_class
-                const JS::Value& reserved_value = JS::GetReservedSlot(&obj, SLOT_OBJECT_PTR);
-                auto* data = reinterpret_cast<class_registration_data_ptr*>(reserved_value.toPrivate());
-                return data->get()->make_any_(data);
+            if (const auto* info = get_registered_class_info(&obj); info != nullptr && JS::GetReservedSlot(&obj, SLOT_FLAGS).isInt32()) {
+                return info->make_any_(&obj);
             } else if (JS::IsArrayObject(cx, v, &is_array) && is_array) {
                 return spidermonkey::from_js<std::vector<any>>(cx, v).transform([&](auto value) -> std::unique_ptr<any_impl> {
                     return std::make_unique<any_array_impl<any>>(std::move(value));
@@ -475,10 +887,10 @@ inline result<any> converter<any>::from_js(JSContext* cx, JS::HandleValue v)
         case JS::ValueType::Symbol:
         case JS::ValueType::PrivateGCThing:
         case JS::ValueType::BigInt:
-            return unexpected("Attempted to wrap unsupported value type");
+            return unexpected(error { error_code::conversion_failed, "Attempted to wrap unsupported value type" });
         }
 
-        return unexpected("Could not create any from unrecognized type");
+        return unexpected(error { error_code::conversion_failed, "Could not create any from unrecognized type" });
     }()
                         .transform([&](auto any_impl_ptr) {
                             return any { std::move(any_impl_ptr) };
@@ -492,10 +904,30 @@ auto many_to_js([[maybe_unused]] JSContext* cx, Ts&&... values)
     return many_results_to_one(std::move(many_expected));
 }
 
-template <typename... Ts>
-auto many_from_js([[maybe_unused]] JSContext* cx, HandleValueFor<Ts>... vs)
-{
-    auto many_expected = std::make_tuple(from_js<Ts>(cx, vs)...);
-    return many_results_to_one(std::move(many_expected));
+// each argument is converted in place, one recursion level each, and reaches f as a reference to the value
+// in its level's result. Nothing is gathered into a tuple of results or moved into a tuple of values, and
+// the first failure returns without converting the rest. A std::string_view argument's level also holds
+// the stable chars it views, which stay in place until f has returned
+template <typename R, std::size_t I, typename... Ts, typename Values, typename F, typename... Converted>
+R apply_from_js(JSContext* cx, const Values& values, F&& f, Converted&&... converted)
+{
+    if constexpr (I == sizeof...(Ts)) {
+        return static_cast<F&&>(f)(static_cast<Converted&&>(converted)...);
+    } else if constexpr (decays_to<std::tuple_element_t<I, std::tuple<Ts...>>, std::string_view>) {
+        JS::AutoStableStringChars chars { cx };
+        auto arg = string_view_from_js(cx, values(I), chars);
+        if (!arg.has_value()) {
+            return unexpected(std::move(arg).error());
+        }
+
+        return apply_from_js<R, I + 1, Ts...>(cx, values, static_cast<F&&>(f), static_cast<Converted&&>(converted)..., std::move(arg).value());
+    } else {
+        auto arg = from_js<std::tuple_element_t<I, std::tuple<Ts...>>>(cx, values(I));
+        if (!arg.has_value()) {
+            return unexpected(std::move(arg).error());
+        }
+
+        return apply_from_js<R, I + 1, Ts...>(cx, values, static_cast<F&&>(f), static_cast<Converted&&>(converted)..., std::move(arg).value());
+    }
 }
 }
@@ -4,70 +4,57 @@
 // crafted to separate declarations and dependent definitions
 
 namespace glua::spidermonkey {
+// Functor is anything with a call(ArgTypes...) member, i.e. a generic_functor or a static_functor
+template <typename ReturnType, typename... ArgTypes, typename Functor>
+bool call_wrapped_functor(Functor& f, JSContext* cx, JS::CallArgs& args)
+{
+    auto values = [&](std::size_t i) { return args.get(i); };
+    auto outcome = apply_from_js<result<void>, 0, ArgTypes...>(cx, values, [&](auto&&... unwrapped_args) -> result<void> {
+        if constexpr (std::same_as<ReturnType, void>) {
+            f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
+            return {};
+        } else {
+            return to_js(cx, f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...))
+                .transform([&](auto v) { args.rval().set(v); });
+        }
+    });
+
+    if (!outcome.has_value()) {
+        JS_ReportErrorASCII(cx, "%s", outcome.error().c_str());
+        return false;
+    }
+
+    return true;
+}
+
 template <typename ReturnType, typename... ArgTypes>
 bool call_generic_wrapped_functor(generic_functor<ReturnType, ArgTypes...>& f, JSContext* cx, JS::CallArgs& args)
 {
-    return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-        return many_from_js<ArgTypes...>(cx, args.get(Is)...).and_then([&](auto actual_args) -> result<void> {
-            if constexpr (std::same_as<ReturnType, void>) {
-                std::apply(
-                    [&](auto&&... unwrapped_args) -> ReturnType {
-                        f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
-                    },
-                    std::move(actual_args));
-
-                return {};
-            } else {
-                return to_js(
-                    cx,
-                    std::apply(
-                        [&](auto&&... unwrapped_args) -> ReturnType {
-                            return f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
-                        },
-                        std::move(actual_args)))
-                    .transform([&](auto v) { args.rval().set(v); });
-            }
-        });
-    }(std::index_sequence_for<ArgTypes...> {})
-               .transform([]() { return true; })
-               .or_else([&](const auto& error) -> result<bool> {
-                   JS_ReportErrorASCII(cx, "%s", error.data());
-                   return false;
-               })
-               .value();
+    return call_wrapped_functor<ReturnType, ArgTypes...>(f, cx, args);
 }
 
-template <typename ReturnType, typename ClassType, typename... ArgTypes>
-bool call_generic_wrapped_method(generic_functor<ReturnType, ClassType, ArgTypes...>& f, JSContext* cx, JS::CallArgs& args)
+// Args is either JS::CallArgs, or JSJitMethodCallArgs when called directly by the JIT
+template <typename ReturnType, typename ClassType, typename... ArgTypes, typename Args>
+bool call_generic_wrapped_method(generic_functor<ReturnType, ClassType, ArgTypes...>& f, JSContext* cx, JS::HandleValue thisv, Args& args)
 {
-    return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
-        return many_from_js<ClassType, ArgTypes...>(cx, args.thisv(), args.get(Is)...).and_then([&](auto actual_args) -> result<void> {
-            if constexpr (std::same_as<ReturnType, void>) {
-                std::apply(
-                    [&](auto&&... unwrapped_args) -> ReturnType {
-                        f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
-                    },
-                    std::move(actual_args));
-
-                return {};
-            } else {
-                return to_js(
-                    cx,
-                    std::apply(
-                        [&](auto&&... unwrapped_args) -> ReturnType {
-                            return f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
-                        },
-                        std::move(actual_args)))
-                    .transform([&](auto v) { args.rval().set(v); });
-            }
-        });
-    }(std::index_sequence_for<ArgTypes...> {})
-               .transform([]() { return true; })
-               .or_else([&](const auto& error) -> result<bool> {
-                   JS_ReportErrorASCII(cx, "%s", error.data());
-                   return false;
-               })
-               .value();
+    // the object is converted first, as the value before the arguments
+    auto values = [&](std::size_t i) -> JS::HandleValue { return i == 0 ? thisv : args.get(i - 1); };
+    auto outcome = apply_from_js<result<void>, 0, ClassType, ArgTypes...>(cx, values, [&](auto&&... unwrapped_args) -> result<void> {
+        if constexpr (std::same_as<ReturnType, void>) {
+            f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...);
+            return {};
+        } else {
+            return to_js(cx, f.call(std::forward<decltype(unwrapped_args)>(unwrapped_args)...))
+                .transform([&](auto v) { args.rval().set(v); });
+        }
+    });
+
+    if (!outcome.has_value()) {
+        JS_ReportErrorASCII(cx, "%s", outcome.error().c_str());
+        return false;
+    }
+
+    return true;
 }
 
 template <typename ReturnType, typename... ArgTypes>
@@ -84,6 +71,9 @@ bool generic_wrapped_functor(JSContext* cx, unsigned argc, JS::Value* vp)
     const JS::Value& v = js::GetFunctionNativeReserved(&func, 0);
     auto* functor = reinterpret_cast<generic_functor<ReturnType, ArgTypes...>*>(v.toPrivate());
 
+    const JS::Value& name = js::GetFunctionNativeReserved(&func, 1);
+    profiler_label label { cx, static_cast<const char*>(name.toPrivate()) };
+
     return call_generic_wrapped_functor(*functor, cx, args);
 }
 
@@ -92,4 +82,24 @@ JSNative callback_for(const generic_functor<ReturnType, ArgTypes...>&)
 {
     return &generic_wrapped_functor<ReturnType, ArgTypes...>;
 }
+
+// static functors skip the profiler label along with the reserved slots, they exist to do nothing but the call
+template <auto F, typename ReturnType, typename... ArgTypes>
+bool static_wrapped_functor(JSContext* cx, unsigned argc, JS::Value* vp)
+{
+    if (argc != sizeof...(ArgTypes)) {
+        JS_ReportErrorASCII(cx, "Invalid number of arguments");
+        return false;
+    }
+
+    auto args = JS::CallArgsFromVp(argc, vp);
+    static_functor<F, ReturnType, ArgTypes...> f;
+    return call_wrapped_functor<ReturnType, ArgTypes...>(f, cx, args);
+}
+
+template <auto F, typename ReturnType, typename... ArgTypes>
+JSNative callback_for(const static_functor<F, ReturnType, ArgTypes...>&)
+{
+    return &static_wrapped_functor<F, ReturnType, ArgTypes...>;
+}
 }
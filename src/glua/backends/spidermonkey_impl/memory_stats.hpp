@@ -0,0 +1,118 @@
+#pragma once
+
+// NOTE: Do not include this, include glua/backends/spidermonkey.hpp instead, the include order is carefully
+// crafted to separate declarations and dependent definitions
+
+// the allocator spidermonkey's heap was allocated with, which malloc_size_of has to ask about sizes
+#if defined(MOZ_MEMORY)
+#include <mozilla/mozalloc.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace glua::spidermonkey {
+// memory held by the JIT tiers across every realm of a context
+struct jit_memory {
+    // per-script state created once a script is warm enough to leave the interpreter
+    std::size_t jit_scripts_bytes_;
+    std::size_t baseline_bytes_;
+    std::size_t ion_bytes_;
+};
+
+// memory attributed to one sandbox
+struct sandbox_memory {
+    // the sandbox's objects, scripts and other things in the GC heap
+    std::size_t gc_heap_bytes_;
+    // slots, elements and other data allocated outside the GC heap for them
+    std::size_t malloc_heap_bytes_;
+    // bytecode and other script data, already included in the above
+    std::size_t script_bytes_;
+    // baseline and ion data of the sandbox's scripts, already included in the above
+    std::size_t jit_bytes_;
+    // strings and other data held per zone rather than per realm. Sandboxes sharing a compartment share
+    // a zone too, and each reports the zone's total
+    std::size_t zone_bytes_;
+};
+
+// the usable size of a block spidermonkey allocated. A mozjs built with its own jemalloc (MOZ_MEMORY, set in
+// js-config.h) allocates from it rather than the system allocator, so it has to be asked instead
+inline std::size_t malloc_size_of(const void* ptr)
+{
+#if defined(MOZ_MEMORY)
+    return moz_malloc_size_of(ptr);
+#elif defined(_WIN32)
+    return ptr != nullptr ? _msize(const_cast<void*>(ptr)) : 0;
+#elif defined(__APPLE__)
+    return malloc_size(ptr);
+#else
+    return malloc_usable_size(const_cast<void*>(ptr));
+#endif
+}
+
+// a walk of the whole heap of a context, attributing everything to the zone and realm holding it. The
+// stats of each carry the zone or realm itself in their extra pointer, so they can be matched to a sandbox
+class runtime_stats final : public JS::RuntimeStats {
+public:
+    runtime_stats()
+        : JS::RuntimeStats(malloc_size_of)
+    {
+    }
+
+    static result<std::unique_ptr<runtime_stats>> collect(JSContext* cx)
+    {
+        auto stats = std::make_unique<runtime_stats>();
+        if (!JS::CollectRuntimeStats(cx, stats.get(), nullptr, false)) {
+            return unexpected(error { error_code::engine_failure, "Spidermonkey failed to collect runtime stats" });
+        }
+
+        return stats;
+    }
+
+    // a scope without stats (e.g. created after the walk) reports nothing
+    sandbox_memory memory_of(JSObject* scope) const
+    {
+        sandbox_memory memory {};
+
+        JS::Realm* realm = JS::GetObjectRealmOrNull(scope);
+        for (const auto& stats : realmStatsVector) {
+            if (stats.extra != realm) {
+                continue;
+            }
+
+            JS::ServoSizes sizes;
+            stats.addToServoSizes(&sizes);
+            memory.gc_heap_bytes_ = sizes.gcHeapUsed;
+            memory.malloc_heap_bytes_ = sizes.mallocHeap + sizes.nonHeap;
+            memory.script_bytes_ = stats.scriptsGCHeap + stats.scriptsMallocHeapData;
+            memory.jit_bytes_ = stats.baselineData + stats.ionData + stats.jitScripts;
+        }
+
+        JS::Zone* zone = JS::GetObjectZone(scope);
+        for (const auto& stats : zoneStatsVector) {
+            if (stats.extra != zone) {
+                continue;
+            }
+
+            JS::ServoSizes sizes;
+            stats.addToServoSizes(&sizes);
+            memory.zone_bytes_ = sizes.gcHeapUsed + sizes.mallocHeap + sizes.nonHeap;
+        }
+
+        return memory;
+    }
+
+    void initExtraZoneStats(JS::Zone* zone, JS::ZoneStats* stats, const JS::AutoRequireNoGC&) override
+    {
+        stats->extra = zone;
+    }
+
+    void initExtraRealmStats(JS::Realm* realm, JS::RealmStats* stats, const JS::AutoRequireNoGC&) override
+    {
+        stats->extra = realm;
+    }
+};
+}
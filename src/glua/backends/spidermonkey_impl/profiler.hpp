@@ -0,0 +1,196 @@
+#pragma once
+
+// NOTE: Do not include this, include glua/backends/spidermonkey.hpp instead, the include order is carefully
+// crafted to separate declarations and dependent definitions
+
+namespace glua::spidermonkey {
+// names the C++ functor or method running for the duration of a call, so samples taken while it runs are
+// attributed to it rather than to an anonymous native frame. Does nothing while profiling is off
+class profiler_label {
+public:
+    profiler_label(JSContext* cx, const char* label, const char* dynamic_string = nullptr)
+        : cx_(cx)
+        , stack_(get_context_data(cx).profiling_stack_)
+    {
+        if (stack_ != nullptr)
+            stack_->pushLabelFrame(label, dynamic_string, this, JS::ProfilingCategoryPair::OTHER);
+    }
+
+    profiler_label(const profiler_label&) = delete;
+    profiler_label& operator=(const profiler_label&) = delete;
+
+    ~profiler_label()
+    {
+        if (stack_ != nullptr) {
+            // scripts only take samples at interrupt checks, which a C++ call never reaches, so a sample
+            // asked for while it ran is taken here, with its label still on the stack
+            get_context_data(cx_).sample_profiler();
+            stack_->pop();
+        }
+    }
+
+private:
+    JSContext* cx_;
+    js::ProfilingStack* stack_;
+};
+
+// samples the stacks of a context at a fixed interval. A background thread only counts elapsed intervals and
+// asks for a sample through the interrupt callback, and every sample is taken on the context's own thread at
+// an interrupt check or when a bound C++ call returns, where the profiling stack and the JIT frames are safe
+// to read. A sample weighs as many intervals as elapsed since the last one, so a C++ call running for many
+// intervals counts for all of them rather than once. Spidermonkey
+// pushes a frame for every JS function the interpreter enters and profiler_label one for every bound C++
+// call, and JIT frames are found by walking the native stack, so the samples are merged JS, JIT and C++
+// stacks. Samples are accumulated as folded stacks, the format flame graph tools consume
+class profiler {
+public:
+    profiler(JSContext* cx, std::chrono::microseconds interval)
+        : cx_(cx)
+        , interval_(interval)
+    {
+        js::SetContextProfilingStack(cx_, &stack_);
+        js::EnableContextProfilingStack(cx_, true);
+        get_context_data(cx_).profiling_stack_ = &stack_;
+        get_context_data(cx_).profiler_ = this;
+
+        thread_ = std::thread { [this]() { run(); } };
+    }
+
+    profiler(const profiler&) = delete;
+    profiler& operator=(const profiler&) = delete;
+
+    // must not be destroyed while a script is running on the context
+    ~profiler()
+    {
+        {
+            std::lock_guard lock { mutex_ };
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+
+        get_context_data(cx_).profiler_ = nullptr;
+        get_context_data(cx_).profiling_stack_ = nullptr;
+        js::EnableContextProfilingStack(cx_, false);
+        js::SetContextProfilingStack(cx_, nullptr);
+    }
+
+    // one line per distinct stack, outermost frame first: "frame;frame;frame count"
+    std::string folded_stacks() const
+    {
+        std::lock_guard lock { mutex_ };
+
+        std::string folded;
+        for (const auto& [stack, count] : samples_) {
+            folded += std::format("{} {}\n", stack, count);
+        }
+        return folded;
+    }
+
+    // called on the context's thread, takes a sample weighing the intervals elapsed since the last, if any
+    void take_requested_sample()
+    {
+        const auto ticks = elapsed_ticks_.exchange(0, std::memory_order_relaxed);
+        if (ticks == 0) {
+            return;
+        }
+
+        if (auto stack = sample(); !stack.empty()) {
+            std::lock_guard lock { mutex_ };
+            samples_[stack] += ticks;
+        }
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock lock { mutex_ };
+        while (!wake_.wait_for(lock, interval_, [&]() { return stopping_; })) {
+            // idle time isn't counted, it would be added to whatever the context runs next. The stack
+            // pointer is atomic, so it can be read from this thread
+            if (stack_.stackSize() == 0) {
+                continue;
+            }
+
+            // one request covers every tick until the context takes the sample
+            if (elapsed_ticks_.fetch_add(1, std::memory_order_relaxed) == 0) {
+                JS_RequestInterruptCallback(cx_);
+            }
+        }
+    }
+
+    std::string sample() const
+    {
+        // JIT frames innermost first, with inlined frames expanded
+        std::vector<std::pair<std::uintptr_t, const char*>> jit_frames;
+        for (JS::ProfilingFrameIterator it { cx_, JS::ProfilingFrameIterator::RegisterState {} }; !it.done(); ++it) {
+            std::array<JS::ProfilingFrameIterator::Frame, 16> frames;
+            const uint32_t count = it.extractStack(frames.data(), 0, frames.size());
+            for (uint32_t i = 0; i < count; ++i) {
+                jit_frames.emplace_back(reinterpret_cast<std::uintptr_t>(frames[i].stackAddress), frames[i].label);
+            }
+        }
+
+        std::string folded;
+        auto append = [&](std::string_view frame) {
+            if (!folded.empty())
+                folded += ';';
+            folded += frame;
+        };
+
+        // the native stack grows down, so JIT frames at higher addresses than a label frame were entered
+        // before it. Interpreter frames carry no address and keep their place on the profiling stack
+        auto next_jit = jit_frames.rbegin();
+        for (uint32_t i = 0; i < stack_.stackSize(); ++i) {
+            const auto& frame = stack_.frames[i];
+            if (frame.isOSRFrame()) {
+                // the interpreter frame of a script which moved into JIT code, the JIT walk reports it
+                continue;
+            }
+
+            if (!frame.isJsFrame()) {
+                const auto address = reinterpret_cast<std::uintptr_t>(frame.stackAddress());
+                for (; next_jit != jit_frames.rend() && next_jit->first > address; ++next_jit) {
+                    append(next_jit->second != nullptr ? next_jit->second : "");
+                }
+            }
+
+            // bound methods label as the method with the class as the dynamic string, JS frames only
+            // carry a dynamic string naming the function and its location
+            const char* label = frame.label();
+            const char* dynamic_string = frame.dynamicString();
+            if (dynamic_string != nullptr && label != nullptr && *label != '\0')
+                append(std::format("{}.{}", dynamic_string, label));
+            else if (dynamic_string != nullptr)
+                append(dynamic_string);
+            else if (label != nullptr)
+                append(label);
+        }
+
+        for (; next_jit != jit_frames.rend(); ++next_jit) {
+            append(next_jit->second != nullptr ? next_jit->second : "");
+        }
+
+        return folded;
+    }
+
+    JSContext* cx_;
+    std::chrono::microseconds interval_;
+    js::ProfilingStack stack_;
+    std::atomic<std::size_t> elapsed_ticks_ { 0 };
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ { false };
+    std::unordered_map<std::string, std::size_t> samples_;
+
+    std::thread thread_;
+};
+
+inline void context_data::sample_profiler()
+{
+    if (profiler_ != nullptr) {
+        profiler_->take_requested_sample();
+    }
+}
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+// NOTE: Do not include this, include glua/backends/spidermonkey.hpp instead, the include order is carefully
+// crafted to separate declarations and dependent definitions
+
+namespace glua::spidermonkey {
+// FNV-1a, chosen over std::hash as the value must be stable across processes and builds
+inline uint64_t stable_hash(std::string_view bytes, uint64_t value = 0xcbf29ce484222325ull)
+{
+    for (char c : bytes) {
+        value ^= static_cast<uint8_t>(c);
+        value *= 0x100000001b3ull;
+    }
+    return value;
+}
+
+// the file spidermonkey was loaded from, the shared library or the executable it's linked into
+inline std::filesystem::path engine_binary_path()
+{
+    const void* engine_function = reinterpret_cast<const void*>(&JS_GetImplementationVersion);
+#ifdef _WIN32
+    HMODULE module { nullptr };
+    char path[MAX_PATH];
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCSTR>(engine_function), &module)) {
+        auto length = GetModuleFileNameA(module, path, MAX_PATH);
+        if (length > 0 && length < MAX_PATH) {
+            return std::filesystem::path { std::string_view { path, length } };
+        }
+    }
+#else
+    Dl_info info;
+    if (dladdr(engine_function, &info) != 0 && info.dli_fname != nullptr) {
+        return info.dli_fname;
+    }
+#endif
+    return {};
+}
+
+// identifies the exact spidermonkey build, XDR data must only ever be decoded by the build which encoded
+// it. The version alone is shared by every build of a release, so the engine binary's path, size and
+// modification time are added. A rebuilt or reinstalled engine changes at least one of them, and reading
+// them costs a stat rather than reading the whole binary at every process start
+inline const std::string& engine_build_id()
+{
+    static const std::string build_id = []() {
+        uint64_t value = stable_hash(JS_GetImplementationVersion());
+
+        const auto path = engine_binary_path();
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        const auto modified = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        value = stable_hash(std::format("{}\n{}\n{}", path.string(), size, modified), value);
+
+        return std::format("glua-{:016x}", value);
+    }();
+
+    return build_id;
+}
+
+// distinguishes writers sharing a cache directory, processes by their id and threads within them by theirs
+inline std::string writer_id()
+{
+#ifdef _WIN32
+    const uint64_t process = GetCurrentProcessId();
+#else
+    const uint64_t process = static_cast<uint64_t>(getpid());
+#endif
+    return std::format("{}-{:x}", process, std::hash<std::thread::id> {}(std::this_thread::get_id()));
+}
+
+// installed as the process build id op, which spidermonkey asks for whenever it encodes or decodes XDR
+inline bool engine_build_id_op(JS::BuildIdCharVector* build_id)
+{
+    const auto& id = engine_build_id();
+    return build_id->append(id.data(), id.size());
+}
+
+struct script_cache_stats {
+    std::size_t hits_;
+    std::size_t misses_;
+    std::size_t stores_;
+    std::size_t evictions_;
+};
+
+// on-disk cache of compiled stencils, encoded with spidermonkey's XDR transcoder. Entries are keyed
+// by a hash of the source and carry the engine build id they were encoded with, so a changed script
+// or a different spidermonkey build simply misses the cache and recompiles. The directory is bounded,
+// the least recently used entries are evicted once it grows past max_bytes
+class script_cache {
+public:
+    static constexpr std::uintmax_t default_max_bytes { 64 * 1024 * 1024 };
+
+    static result<script_cache> create(std::filesystem::path directory, std::uintmax_t max_bytes = default_max_bytes)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            return unexpected(std::format("Could not create script cache directory {}: {}", directory.string(), ec.message()));
+        }
+
+        return script_cache { std::move(directory), max_bytes };
+    }
+
+    // returns nullptr on a cache miss, including stale or unreadable entries
+    RefPtr<JS::Stencil> load(JSContext* cx, const JS::ReadOnlyCompileOptions& options, std::string_view code) const
+    {
+        const auto source_hash = stable_hash(code);
+        const auto path = path_for(source_hash);
+
+        std::ifstream file { path, std::ios::binary | std::ios::ate };
+        if (!file) {
+            ++stats_.misses_;
+            return nullptr;
+        }
+
+        const auto file_size = static_cast<std::size_t>(file.tellg());
+        file.seekg(0, std::ios::beg);
+
+        std::string contents;
+        contents.resize(file_size);
+        if (!file.read(contents.data(), contents.size())) {
+            ++stats_.misses_;
+            return nullptr;
+        }
+
+        const auto header = make_header(source_hash, code.size());
+        if (!contents.starts_with(header)) {
+            ++stats_.misses_;
+            return nullptr;
+        }
+
+        JS::TranscodeRange range {
+            reinterpret_cast<const uint8_t*>(contents.data()) + header.size(),
+            contents.size() - header.size()
+        };
+
+        JS::DecodeOptions decode_options { options };
+        JS::Stencil* stencil { nullptr };
+        if (JS::DecodeStencil(cx, decode_options, range, &stencil) != JS::TranscodeResult::Ok) {
+            // a failed decode is only a miss, not an error for the caller
+            clear_failure(cx);
+            ++stats_.misses_;
+            return nullptr;
+        }
+
+        // a hit makes the entry the most recently used, eviction goes by modification time
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+        ++stats_.hits_;
+        return RefPtr<JS::Stencil> { already_AddRefed<JS::Stencil> { stencil } };
+    }
+
+    // best effort, a failure to store only means the next start compiles from source again
+    void store(JSContext* cx, std::string_view code, JS::Stencil* stencil) const
+    {
+        JS::TranscodeBuffer buffer;
+        if (JS::EncodeStencil(cx, stencil, buffer) != JS::TranscodeResult::Ok) {
+            clear_failure(cx);
+            return;
+        }
+
+        const auto source_hash = stable_hash(code);
+        const auto header = make_header(source_hash, code.size());
+        const auto final_path = path_for(source_hash);
+
+        // write under a name unique to this process and thread and rename over the entry, so concurrent
+        // processes starting against the same directory never observe a partially written file
+        auto temp_path = final_path;
+        temp_path += std::format(".{}.tmp", writer_id());
+
+        {
+            std::ofstream file { temp_path, std::ios::binary | std::ios::trunc };
+            file.write(header.data(), header.size());
+            file.write(reinterpret_cast<const char*>(buffer.begin()), buffer.length());
+            if (!file) {
+                std::error_code ec;
+                std::filesystem::remove(temp_path, ec);
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp_path, final_path, ec);
+        if (ec) {
+            std::filesystem::remove(temp_path, ec);
+            return;
+        }
+
+        ++stats_.stores_;
+        evict();
+    }
+
+    script_cache_stats stats() const { return stats_; }
+
+    // the header every entry starts with, entries with any other header are misses
+    static std::string make_header(uint64_t source_hash, std::size_t source_size)
+    {
+        return std::format("glua-xdr-{}\n{}\n{:016x}:{}\n", format_version, engine_build_id(), source_hash, source_size);
+    }
+
+    std::filesystem::path path_for(std::string_view code) const { return path_for(stable_hash(code)); }
+
+private:
+    script_cache(std::filesystem::path directory, std::uintmax_t max_bytes)
+        : directory_(std::move(directory))
+        , max_bytes_(max_bytes)
+    {
+    }
+
+    // a failed transcode reports itself as an out of memory error, which must not be mistaken for the
+    // heap limit having been reached by whatever the context does next
+    static void clear_failure(JSContext* cx)
+    {
+        JS_ClearPendingException(cx);
+        get_context_data(cx).out_of_memory_ = false;
+    }
+
+    // removes the least recently used entries until the directory fits in max_bytes_. Only run after
+    // a store, which is rare next to loads
+    void evict() const
+    {
+        struct entry {
+            std::filesystem::path path_;
+            std::uintmax_t size_;
+            std::filesystem::file_time_type used_;
+        };
+
+        std::vector<entry> entries;
+        std::uintmax_t total { 0 };
+
+        std::error_code ec;
+        for (const auto& file : std::filesystem::directory_iterator { directory_, ec }) {
+            if (file.path().extension() != ".xdr") {
+                continue;
+            }
+
+            std::error_code entry_ec;
+            auto size = file.file_size(entry_ec);
+            auto used = file.last_write_time(entry_ec);
+            if (!entry_ec) {
+                entries.push_back({ file.path(), size, used });
+                total += size;
+            }
+        }
+
+        if (total <= max_bytes_) {
+            return;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) { return lhs.used_ < rhs.used_; });
+        for (const auto& oldest : entries) {
+            if (total <= max_bytes_) {
+                break;
+            }
+
+            if (std::filesystem::remove(oldest.path_, ec)) {
+                total -= oldest.size_;
+                ++stats_.evictions_;
+            }
+        }
+    }
+
+    std::filesystem::path path_for(uint64_t source_hash) const
+    {
+        return directory_ / std::format("{:016x}.xdr", source_hash);
+    }
+
+    static constexpr int format_version { 2 };
+
+    std::filesystem::path directory_;
+    std::uintmax_t max_bytes_;
+    mutable script_cache_stats stats_ {};
+};
+}
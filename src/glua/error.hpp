@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace glua {
+// what kind of failure an error is, so callers can react to it without inspecting the message
+enum class error_code : uint8_t {
+    unknown,
+    conversion_failed,
+    invalid_arguments,
+    not_found,
+    script_failed,
+    engine_failure,
+    out_of_memory,
+    deadline_exceeded
+};
+
+constexpr const char* describe(error_code code)
+{
+    switch (code) {
+    case error_code::conversion_failed:
+        return "value could not be converted";
+    case error_code::invalid_arguments:
+        return "invalid arguments";
+    case error_code::not_found:
+        return "not found";
+    case error_code::script_failed:
+        return "script failed";
+    case error_code::engine_failure:
+        return "script engine failure";
+    case error_code::out_of_memory:
+        return "out of memory";
+    case error_code::deadline_exceeded:
+        return "deadline exceeded";
+    case error_code::unknown:
+        break;
+    }
+
+    return "unknown error";
+}
+
+// detail text an error keeps by pointer rather than copying. The constructor is consteval, so only a
+// constant with static storage, i.e. a string literal, can become one: a const char array on the stack
+// doesn't compile and has to be passed as a std::string. It must be converted where the literal is
+// written, forwarding the literal through a template first makes it an ordinary reference
+class error_literal {
+public:
+    template <std::size_t N>
+    consteval error_literal(const char (&text)[N]) noexcept
+        : text_(text)
+    {
+    }
+
+    const char* get() const noexcept { return text_; }
+
+private:
+    const char* text_;
+};
+
+// the error of a glua::result, a code with optional detail text. Detail given as a string literal is kept by
+// pointer and anything else is copied and shared behind a reference count, so an error is two words,
+// copying one never allocates and the fixed errors of the conversions don't touch string machinery at all.
+// Detail built with error::format is only formatted once its message is first read
+class error {
+    template <typename Text>
+    static constexpr bool copied_text = std::convertible_to<Text, std::string> && !std::is_array_v<std::remove_cvref_t<Text>>;
+
+public:
+    error(error_code code) noexcept
+        : code_(code)
+    {
+    }
+
+    error(error_literal literal) noexcept
+        : error(error_code::unknown, literal)
+    {
+    }
+
+    error(error_code code, error_literal literal) noexcept
+        : code_(code)
+        , literal_(literal.get())
+    {
+    }
+
+    // a buffer filled at runtime is copied, it's usually gone long before the error is read
+    template <std::size_t N>
+    error(char (&buffer)[N])
+        : error(error_code::unknown, buffer)
+    {
+    }
+
+    template <std::size_t N>
+    error(error_code code, char (&buffer)[N])
+        : error(code, std::string { buffer, std::find(buffer, buffer + N, '\0') })
+    {
+    }
+
+    template <typename Text>
+        requires copied_text<Text>
+    error(Text&& text)
+        : error(error_code::unknown, std::string { std::forward<Text>(text) })
+    {
+    }
+
+    template <typename Text>
+        requires copied_text<Text>
+    error(error_code code, Text&& text)
+        : code_(code)
+        , owned_(true)
+        , shared_(new owned_text { std::string { std::forward<Text>(text) } })
+    {
+    }
+
+    // an error whose detail is format applied to args, formatted the first time message() is called rather
+    // than here. Args are copied into the error, with strings (and pointers to them) copied as std::string
+    // so the error doesn't depend on their lifetime. format must be a string literal
+    template <typename... Args>
+    static error format(error_code code, std::format_string<Args...> format, Args&&... args)
+    {
+        error e { code };
+        e.owned_ = true;
+        e.shared_ = new deferred_text<captured_t<Args>...> { format.get(), captured_t<Args>(std::forward<Args>(args))... };
+        return e;
+    }
+
+    error(const error& copy) noexcept
+        : code_(copy.code_)
+    {
+        adopt(copy);
+        if (owned_)
+            shared_->references_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    error(error&& move) noexcept
+        : code_(move.code_)
+    {
+        adopt(move);
+        move.owned_ = false;
+        move.literal_ = nullptr;
+    }
+
+    error& operator=(const error& copy) noexcept
+    {
+        if (this != &copy) {
+            error temp { copy };
+            *this = std::move(temp);
+        }
+        return *this;
+    }
+
+    error& operator=(error&& move) noexcept
+    {
+        if (this != &move) {
+            release();
+            code_ = move.code_;
+            adopt(move);
+            move.owned_ = false;
+            move.literal_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~error() { release(); }
+
+    error_code code() const noexcept { return code_; }
+
+    // the detail text, or a description of the code when there is none
+    std::string_view message() const
+    {
+        if (owned_)
+            return shared_->text();
+
+        return literal_ != nullptr ? literal_ : describe(code_);
+    }
+
+    // message() is always null terminated, for handing to C APIs
+    const char* c_str() const { return message().data(); }
+
+    friend std::ostream& operator<<(std::ostream& out, const error& e) { return out << e.message(); }
+
+private:
+    struct shared_text {
+        virtual ~shared_text() = default;
+        virtual std::string_view text() const = 0;
+
+        std::atomic<std::size_t> references_ { 1 };
+    };
+
+    struct owned_text final : shared_text {
+        explicit owned_text(std::string text)
+            : text_(std::move(text))
+        {
+        }
+
+        std::string_view text() const override { return text_; }
+
+        std::string text_;
+    };
+
+    template <typename T>
+    using captured_t = std::conditional_t<std::is_convertible_v<const std::decay_t<T>&, std::string_view>, std::string, std::decay_t<T>>;
+
+    template <typename... Captured>
+    struct deferred_text final : shared_text {
+        template <typename... Args>
+        explicit deferred_text(std::string_view format, Args&&... args)
+            : format_(format)
+            , args_(std::forward<Args>(args)...)
+        {
+        }
+
+        // copies of an error share this, and may read it from several threads at once
+        std::string_view text() const override
+        {
+            std::call_once(formatted_, [&]() {
+                text_ = std::apply([&](const auto&... args) { return std::vformat(format_, std::make_format_args(args...)); }, args_);
+            });
+            return text_;
+        }
+
+        std::string_view format_;
+        std::tuple<Captured...> args_;
+        mutable std::once_flag formatted_;
+        mutable std::string text_;
+    };
+
+    // takes other's detail without touching its reference count
+    void adopt(const error& other) noexcept
+    {
+        owned_ = other.owned_;
+        if (owned_)
+            shared_ = other.shared_;
+        else
+            literal_ = other.literal_;
+    }
+
+    void release() noexcept
+    {
+        if (owned_ && shared_->references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete shared_;
+        owned_ = false;
+    }
+
+    error_code code_;
+    bool owned_ { false };
+    union {
+        const char* literal_ { nullptr };
+        shared_text* shared_;
+    };
+};
+} // namespace glua
+
+template <>
+struct std::formatter<glua::error> : std::formatter<std::string_view> {
+    auto format(const glua::error& e, std::format_context& ctx) const
+    {
+        return std::formatter<std::string_view>::format(e.message(), ctx);
+    }
+};
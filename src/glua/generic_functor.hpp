@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <type_traits>
 
 namespace glua {
 struct functor {
@@ -55,6 +56,38 @@ constexpr auto create_generic_functor(Functor f)
     return create_generic_functor(std::move(f), &Functor::operator());
 }
 
+// calls F directly rather than through a generic_functor, for functions known at compile time. It has no
+// state, so backends can call it from a trampoline instantiated per function without any allocation,
+// stored pointer or virtual dispatch
+template <auto F, typename ReturnType, typename... ArgTypes>
+struct static_functor {
+    ReturnType call(ArgTypes... args) const { return F(static_cast<ArgTypes&&>(args)...); }
+
+    static constexpr std::size_t num_args { sizeof...(ArgTypes) };
+};
+
+template <auto F, typename ReturnType, typename... ArgTypes>
+constexpr static_functor<F, ReturnType, ArgTypes...> static_functor_for(ReturnType (*)(ArgTypes...))
+{
+    return {};
+}
+
+template <auto F, typename Functor, typename ReturnType, typename... ArgTypes>
+constexpr static_functor<F, ReturnType, ArgTypes...> static_functor_for(ReturnType (Functor::*)(ArgTypes...) const)
+{
+    return {};
+}
+
+// F is a function pointer or a captureless lambda
+template <auto F>
+constexpr auto create_static_functor()
+{
+    if constexpr (std::is_pointer_v<decltype(F)>)
+        return static_functor_for<F>(F);
+    else
+        return static_functor_for<F>(&decltype(F)::operator());
+}
+
 template <typename ReturnType, typename ClassType, typename... ArgTypes>
 constexpr std::unique_ptr<generic_functor<ReturnType, ClassType&, ArgTypes...>>
 create_generic_functor(ReturnType (ClassType::*fp)(ArgTypes...))
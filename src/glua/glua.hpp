@@ -1,6 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <span>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include "any.hpp"
@@ -8,6 +11,7 @@
 #include "helpers.hpp"
 #include "registration.hpp"
 #include "result.hpp"
+#include "watchdog.hpp"
 
 namespace glua {
 
@@ -20,16 +24,27 @@ public:
         return Backend::create(std::forward<CreateArgs>(create_args)...).transform([&](auto backend_ptr) { return instance { std::move(backend_ptr) }; });
     }
 
-    result<typename Backend::sandbox> create_sandbox() { return backend_ptr_->create_sandbox(); }
+    // any arguments are backend specific sandbox options
+    template <typename... SandboxArgs>
+    result<typename Backend::sandbox> create_sandbox(SandboxArgs&&... sandbox_args)
+    {
+        return backend_ptr_->create_sandbox(std::forward<SandboxArgs>(sandbox_args)...);
+    }
+
     auto set_active_sandbox(typename Backend::sandbox* s) { backend_ptr_->set_active_sandbox(s); }
 
     template <typename ReturnType>
     result<ReturnType> execute_script(const std::string& code)
     {
-        if constexpr (std::same_as<ReturnType, void>)
-            backend_ptr_->template execute_script<ReturnType>(code);
-        else
-            return backend_ptr_->template execute_script<ReturnType>(code);
+        return backend_ptr_->template execute_script<ReturnType>(code);
+    }
+
+    // as execute_script, but the script is interrupted and a timeout error returned if it is still
+    // running once the deadline passes. The instance remains usable afterwards
+    template <typename ReturnType>
+    result<ReturnType> execute_script(deadline until, const std::string& code)
+    {
+        return backend_ptr_->template execute_script<ReturnType>(until, code);
     }
 
     template <typename F>
@@ -47,6 +62,14 @@ public:
         return backend_ptr_->register_functor(name, functor);
     }
 
+    // for functions known at compile time: a function pointer or captureless lambda given as F is called
+    // directly by the backend, without the allocation and indirection of register_functor
+    template <auto F>
+    result<void> register_function(const std::string& name)
+    {
+        return backend_ptr_->template register_function<F>(name);
+    }
+
     template <typename T>
     result<T> get_global(const std::string& name)
     {
@@ -65,12 +88,44 @@ public:
         return backend_ptr_->template call_function<ReturnType>(name, std::forward<Args>(args)...);
     }
 
+    template <typename ReturnType, typename... Args>
+    result<ReturnType> call_function(deadline until, const std::string& name, Args&&... args)
+    {
+        return backend_ptr_->template call_function<ReturnType>(until, name, std::forward<Args>(args)...);
+    }
+
+    // calls a script function once per input, writing the results to out, which must be at least as large
+    // as inputs. Cheaper than a call_function per input as the backend only sets up the call once
+    template <typename ReturnType, typename... Args>
+    result<void> call_function_batch(const std::string& name, std::span<const std::tuple<Args...>> inputs, std::span<ReturnType> out)
+    {
+        return backend_ptr_->template call_function_batch<ReturnType>(name, inputs, out);
+    }
+
+    // as above, for inputs kept in a vector, which a span parameter can't deduce its argument types from
+    template <typename ReturnType, typename... Args>
+    result<void> call_function_batch(const std::string& name, const std::vector<std::tuple<Args...>>& inputs, std::span<ReturnType> out)
+    {
+        return backend_ptr_->template call_function_batch<ReturnType>(name, std::span<const std::tuple<Args...>> { inputs }, out);
+    }
+
+    // resolves a script function once, so it can be called repeatedly without looking it up by name,
+    // the handle must not outlive this instance
+    template <typename Signature>
+    result<typename Backend::template function_handle<Signature>> get_function(const std::string& name)
+    {
+        return backend_ptr_->template get_function<Signature>(name);
+    }
+
     template <registered_class T>
-    void register_class()
+    result<void> register_class()
     {
         return backend_ptr_->template register_class<T>();
     }
 
+    // functionality specific to one backend (e.g. tuning or caching) is reached through the backend itself
+    Backend& get_backend() { return *backend_ptr_; }
+
 private:
     instance(std::unique_ptr<Backend> backend_ptr)
         : backend_ptr_(std::move(backend_ptr))
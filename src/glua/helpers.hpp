@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -28,4 +30,15 @@ struct is_unordered_map<std::unordered_map<T, U>> : std::true_type { };
 
 template <typename T>
 concept decays_to_unordered_map = !is_unordered_map<T>::value && is_unordered_map<std::decay_t<T>>::value;
+
+template <typename T>
+struct is_span : std::false_type { };
+
+template <typename T, std::size_t N>
+struct is_span<std::span<T, N>> : std::true_type { };
+
+// views are only valid while the engine keeps the value they point into alive and in place, which it
+// doesn't once a value has been handed back to the caller
+template <typename T>
+concept owning_result = !decays_to<T, std::string_view> && !is_span<std::decay_t<T>>::value;
 }
\ No newline at end of file
@@ -1,25 +1,26 @@
 #pragma once
 
+#include "error.hpp"
+
 #include <expected>
-#include <string>
 #include <tuple>
 
 namespace glua {
 #if __cplusplus > 202002L && __cpp_concepts >= 202002L
 template <typename T>
-using result = std::expected<T, std::string>;
-using unexpected = std::unexpected<std::string>;
+using result = std::expected<T, error>;
+using unexpected = std::unexpected<error>;
 #else
 
 // what follows is a shoddy expected implementation for clang until std::expected is supported
 // this implementation does _far_ less checking to ensure sanity between types and will produce
 // errors when misused that are much more difficult to understand
 struct unexpected {
-    unexpected(std::string error)
-        : error_(std::move(error))
+    unexpected(error e)
+        : error_(std::move(e))
     {
     }
-    std::string error_;
+    error error_;
 };
 
 template <typename F, typename A>
@@ -61,9 +62,9 @@ public:
     result(const result<U>& copy_convert)
         : value_([&]() {
             if (copy_convert.value_.index() == 0) {
-                return std::variant<ValueType, std::string> { std::in_place_index_t<0> {}, std::get<0>(copy_convert.value_) };
+                return std::variant<ValueType, glua::error> { std::in_place_index_t<0> {}, std::get<0>(copy_convert.value_) };
             } else {
-                return std::variant<ValueType, std::string> { std::in_place_index_t<1> {}, std::get<1>(copy_convert.value_) };
+                return std::variant<ValueType, glua::error> { std::in_place_index_t<1> {}, std::get<1>(copy_convert.value_) };
             }
         }())
     {
@@ -74,9 +75,9 @@ public:
     result(result<U>&& move_convert)
         : value_([&]() {
             if (move_convert.value_.index() == 0) {
-                return std::variant<ValueType, std::string> { std::in_place_index_t<0> {}, std::get<0>(std::move(move_convert.value_)) };
+                return std::variant<ValueType, glua::error> { std::in_place_index_t<0> {}, std::get<0>(std::move(move_convert.value_)) };
             } else {
-                return std::variant<ValueType, std::string> { std::in_place_index_t<1> {}, std::get<1>(std::move(move_convert.value_)) };
+                return std::variant<ValueType, glua::error> { std::in_place_index_t<1> {}, std::get<1>(std::move(move_convert.value_)) };
             }
         }())
     {
@@ -89,10 +90,10 @@ public:
     constexpr const ValueType&& value() const&& noexcept { return std::get<0>(std::move(value_)); }
     constexpr ValueType&& value() && noexcept { return std::get<0>(std::move(value_)); }
 
-    constexpr const std::string& error() const& noexcept { return std::get<1>(value_); }
-    constexpr std::string& error() & noexcept { return std::get<1>(value_); }
-    constexpr const std::string&& error() const&& noexcept { return std::get<1>(std::move(value_)); }
-    constexpr std::string&& error() && noexcept { return std::get<1>(std::move(value_)); }
+    constexpr const glua::error& error() const& noexcept { return std::get<1>(value_); }
+    constexpr glua::error& error() & noexcept { return std::get<1>(value_); }
+    constexpr const glua::error&& error() const&& noexcept { return std::get<1>(std::move(value_)); }
+    constexpr glua::error&& error() && noexcept { return std::get<1>(std::move(value_)); }
 
     template <typename U>
     ValueType value_or(U&& default_value) const&
@@ -317,7 +318,7 @@ public:
     }
 
 private:
-    std::variant<ValueType, std::string> value_;
+    std::variant<ValueType, glua::error> value_;
 };
 
 #endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace glua {
+// the point in time by which a script call must have returned
+using deadline = std::chrono::steady_clock::time_point;
+
+// a single process-wide thread which runs a callback for every watched deadline that passes. Backends use
+// it to ask a running script to stop, which it does cooperatively the next time the engine checks
+class watchdog {
+public:
+    // stops watching on destruction, once destroyed the callback is guaranteed to not be running and
+    // to never run
+    class guard {
+    public:
+        guard(watchdog& owner, uint64_t id)
+            : owner_(&owner)
+            , id_(id)
+        {
+        }
+
+        guard(const guard&) = delete;
+        guard(guard&& move)
+            : owner_(std::exchange(move.owner_, nullptr))
+            , id_(move.id_)
+        {
+        }
+
+        ~guard()
+        {
+            if (owner_)
+                owner_->unwatch(id_);
+        }
+
+    private:
+        watchdog* owner_;
+        uint64_t id_;
+    };
+
+    static watchdog& get()
+    {
+        static watchdog instance;
+        return instance;
+    }
+
+    // on_expired runs on the watchdog thread, so it must only do things which are safe from another thread
+    [[nodiscard]] guard watch(deadline when, std::function<void()> on_expired)
+    {
+        std::lock_guard lock { mutex_ };
+        auto id = next_id_++;
+        watched_.emplace(id, watched_call { when, std::move(on_expired) });
+        wake_.notify_one();
+
+        return guard { *this, id };
+    }
+
+    ~watchdog()
+    {
+        {
+            std::lock_guard lock { mutex_ };
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+private:
+    struct watched_call {
+        deadline when_;
+        std::function<void()> on_expired_;
+    };
+
+    watchdog()
+        : thread_([this]() { run(); })
+    {
+    }
+
+    void unwatch(uint64_t id)
+    {
+        std::lock_guard lock { mutex_ };
+        watched_.erase(id);
+    }
+
+    void run()
+    {
+        std::unique_lock lock { mutex_ };
+        while (!stopping_) {
+            // only as many calls are watched as there are threads calling scripts, so a scan is cheap
+            auto next = std::min_element(watched_.begin(), watched_.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.second.when_ < rhs.second.when_;
+            });
+
+            if (next == watched_.end()) {
+                wake_.wait(lock);
+            } else if (next->second.when_ > std::chrono::steady_clock::now()) {
+                wake_.wait_until(lock, next->second.when_);
+            } else {
+                // callbacks run under the lock, which is what lets a guard promise its callback isn't running
+                auto on_expired = std::move(next->second.on_expired_);
+                watched_.erase(next);
+                on_expired();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unordered_map<uint64_t, watched_call> watched_;
+    uint64_t next_id_ { 0 };
+    bool stopping_ { false };
+    std::thread thread_;
+};
+} // namespace glua